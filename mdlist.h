@@ -12,26 +12,123 @@
 #define _mdlist_h_
 
 #include <vector>
+#include <deque>
+#include <queue>
+#include <map>
+#include <algorithm>
 #include <mutex>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <chrono>
+#include <array>
+#include <cstring>
+#include <type_traits>
 #include <cmath>
+#include <climits>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
 #include <exception>
 #include <iostream>
 
 #define ULL unsigned long long
 
+/**
+ * Number of reader slots in a Reclaimer.
+ * Readers are spread over the slots by thread id
+ * to avoid contention on a single counter.
+ */
+#define RECLAIMER_SLOTS 64
+
+/**
+ * Number of objects retired through one reader slot of a
+ * Reclaimer after which it tries to advance its epoch and
+ * free memory.
+ */
+#define RECLAIMER_THRESHOLD 64
+
+/**
+ * Number of striped hit/miss counters in a LookupCache.
+ */
+#define CACHE_COUNTER_SLOTS 16
+
+/**
+ * Size of a cache line in bytes.
+ */
+#define CACHE_LINE 64
+
+/**
+ * Size of a NodeArena region in bytes, a power of 2.
+ */
+#define ARENA_REGION_SIZE (1 << 18)
+
+/**
+ * Number of slots of the timer wheel of expiry times.
+ */
+#define EXPIRY_WHEEL_SLOTS 1024
+
+/**
+ * Time covered by one slot of the timer wheel, in nanoseconds.
+ */
+#define EXPIRY_WHEEL_TICK 16000000ULL
+
+/**
+ * Most expired entries removed by one operation.
+ */
+#define EXPIRY_BATCH 64
+
+/**
+ * Number of Nodes sampled to pick one to evict
+ * when the MDList is over capacity.
+ */
+#define EVICTION_SAMPLES 5
+
+/**
+ * Define MDLIST_COMPACT_NODES before including this file to
+ * store the children of a Node as an occupancy bitmap followed
+ * by only the non NULL children, and to use one byte spin locks
+ * instead of std::mutex. This roughly halves the memory used
+ * per Node. D must be at most 64 in this mode.
+ */
+
+/**
+ * Define MDLIST_ALIGNED_NODES before including this file to
+ * lay out each Node so that a traversal only reads its own
+ * cache lines: the key, coordinates and children follow the
+ * value and locks in one block starting on a new cache line,
+ * and children are read without locking. Nodes use one byte
+ * spin locks and are allocated from a NodeArena, next to their
+ * parent.
+ */
+#if defined(MDLIST_COMPACT_NODES) && defined(MDLIST_ALIGNED_NODES)
+#error "MDLIST_COMPACT_NODES and MDLIST_ALIGNED_NODES cannot be combined"
+#endif
+
 using namespace std;
 
 // Hepler Functions
 
+/**
+ * Largest code of given code type.
+ * @returns All bits set.
+ */
+template <class K>
+inline K maxCode ()
+{
+    return ~(K) 0;
+}
+
 /**
  * Finds nth root of given number.
  * @param X The number.
  * @param n The root.
  * @returns The nth root.
  */
-long nthRoot (ULL X, int n)
+template <class K>
+long nthRoot (K X, int n)
 {
-    long nth_root = trunc(std::pow(X, 1.0 / n));
+    long nth_root = trunc(std::pow((double) X, 1.0 / n));
     // because of rounding error, 
     // it's possible that nth_root + 1 
     // is what we actually want; let's check
@@ -41,6 +138,26 @@ long nthRoot (ULL X, int n)
     return nth_root;
 }
 
+/**
+ * Converts key to its D digits in base M, most
+ * significant first.
+ * @param key The key.
+ * @param D Number of digits.
+ * @param M The base.
+ * @returns Vector of digits.
+ */
+template <class K>
+inline vector<int> keyToDigits (K key, int D, ULL M)
+{
+    vector<int> digits(D);
+    int i = D-1;
+    while (key > 0 && i >= 0) {
+        digits[i--] = key % M;
+        key /= M;
+    }
+    return digits;
+}
+
 /**
  * Converts key to node coordinates.
  * @param key The key.
@@ -48,476 +165,3630 @@ long nthRoot (ULL X, int n)
  * @param N The key space.
  * @returns Vector of coordinates.
  */
-vector<int> keyToCoordinates (ULL key, int D, ULL N)
+template <class K>
+vector<int> keyToCoordinates (K key, int D, K N)
 {
-    int M = nthRoot(N, D);
-    vector<int> coordinates(D);
-    int i = D-1;
-    while (key > 0 && i >= 0) {
-        coordinates[i--] = key % M;
-        key /= M;
+    return keyToDigits(key, D, nthRoot(N, D));
+}
+
+/**
+ * Finds size of key space with D coordinates in [0, M).
+ * @param M Range of a coordinate.
+ * @param D Number of coordinates.
+ * @returns M to the power D, 0 if it does not fit in K.
+ */
+template <class K = ULL>
+K keySpaceSize (ULL M, int D)
+{
+    K N = 1;
+    for (int i = 0; i < D; i++)
+    {
+        if (N > maxCode<K>() / M)
+            return 0;
+        N *= M;
     }
-    return coordinates;
+    return N;
 }
 
 /**
- * Node class.
- * Each node has a key and coordinates in key space
- * and it stores a value. It also has a mutex for
- * thread safety in multi-threaded environment.
+ * Converts node coordinates to key.
+ * Inverse of keyToCoordinates.
+ * @param coordinates The coordinates.
+ * @param D D value of MDList.
+ * @param N The key space.
+ * @returns The key.
  */
-template <class T>
-class Node
+template <class K>
+K coordinatesToKey (const vector<int>& coordinates, int D, K N)
+{
+    ULL M = nthRoot(N, D);
+    K key = 0;
+    for (int i = 0; i < D; i++)
+        key = key * M + coordinates[i];
+    return key;
+}
+
+/**
+ * Converts base M digits to key.
+ * Inverse of keyToDigits.
+ * @param digits The digits, most significant first.
+ * @param D Number of digits.
+ * @param M The base.
+ * @param key Gets the key.
+ * @returns False if the key does not fit in K.
+ */
+template <class K>
+inline bool digitsToKey (const vector<int>& digits, int D, ULL M, K& key)
+{
+    key = 0;
+    for (int i = 0; i < D; i++)
+    {
+        if (key > (maxCode<K>() - digits[i]) / M)
+            return false;
+        key = key * M + digits[i];
+    }
+    return true;
+}
+
+/**
+ * Finds largest key which shares the first d coordinates
+ * with the given coordinates.
+ * @param coordinates The coordinates.
+ * @param d Number of shared coordinates.
+ * @param D D value of MDList.
+ * @param M Range of a coordinate.
+ * @returns The largest key, all bits set if it does not fit in K.
+ */
+template <class K = ULL>
+K prefixMaxKey (const vector<int>& coordinates, int d, int D, ULL M)
+{
+    if (d == 0)
+        return maxCode<K>();
+    vector<int> digits(D, M - 1);
+    for (int i = 0; i < d; i++)
+        digits[i] = coordinates[i];
+    K key;
+    return digitsToKey(digits, D, M, key) ? key : maxCode<K>();
+}
+
+/**
+ * Current time of the steady clock.
+ * @returns The time in nanoseconds.
+ */
+inline ULL steadyNanos ()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Fast per thread pseudo random numbers (xorshift64*).
+ * @returns A random number.
+ */
+inline ULL randomULL ()
+{
+    static thread_local ULL state =
+        std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+}
+
+/**
+ * Deleter used by Reclaimer for objects allocated with new.
+ * @param p The object to delete.
+ */
+template <class X>
+void destroyObject (void* p)
+{
+    delete (X*) p;
+}
+
+/**
+ * Reclaimer class.
+ * Epoch based memory reclamation. Every traversal of
+ * the MDList runs inside a ReclaimGuard, and unlinked
+ * objects are retired instead of deleted. A retired
+ * object is freed only after two epoch advances, when
+ * no traversal which could have seen it is still running.
+ */
+class Reclaimer
 {
     /**
-     * The key.
+     * A retired object with the epoch it was retired in.
      */
-    ULL             key;
+    struct Retired
+    {
+        void*               ptr;
+        void                (*deleter)(void*);
+        ULL                 epoch;
+    };
     /**
-     * The value.
+     * Reader counters of one slot, one per epoch parity, and
+     * the objects retired by the threads of the slot, so
+     * writers do not share a retire list.
+     * Padded to cache lines to avoid false sharing.
      */
-    T               val;
+    struct alignas(64) Slot
+    {
+        std::atomic<long>   count[2];
+        /**
+         * Objects waiting to be freed.
+         */
+        vector<Retired>     retired;
+        /**
+         * Number of objects in retired, read without the lock.
+         */
+        std::atomic<long>   n_retired;
+        /**
+         * Mutex lock for retired.
+         */
+        std::mutex          mutex;
+    };
     /**
-     * The Node coordinates.
-     * This is constant for a given Node.
+     * The reader slots.
      */
-    vector<int>     COORDINATES;
+    Slot                    slots[RECLAIMER_SLOTS];
     /**
-     * The vector of children of this Node.
+     * The global epoch.
      */
-    vector<Node*>   child;
+    std::atomic<ULL>        epoch;
     /**
-     * Mutex lock for this Node.
+     * Mutex lock for epoch advance.
+     */
+    std::mutex              mutex;
+
+    static int              slotOf();
+    bool                    tryAdvance();
+    void                    collect(ULL);
+    public:
+                            Reclaimer();
+                            ~Reclaimer();
+    int                     enter();
+    void                    exit(int);
+    void                    retire(void*, void (*)(void*));
+    void                    synchronize();
+};
+
+/**
+ * Number of guards held by the current thread,
+ * over all reclaimers.
+ * @returns Reference to the counter.
+ */
+inline int& guardDepth ()
+{
+    static thread_local int depth = 0;
+    return depth;
+}
+
+/**
+ * Reclaimer constructor.
+ */
+inline Reclaimer::Reclaimer ()
+{
+    for (int i = 0; i < RECLAIMER_SLOTS; i++)
+    {
+        this->slots[i].count[0] = 0;
+        this->slots[i].count[1] = 0;
+        this->slots[i].n_retired = 0;
+    }
+    this->epoch = 0;
+}
+
+/**
+ * Reclaimer destructor.
+ * Frees every retired object. No traversal
+ * may be running at this point.
+ */
+inline Reclaimer::~Reclaimer ()
+{
+    for (int i = 0; i < RECLAIMER_SLOTS; i++)
+    {
+        vector<Retired>& retired = this->slots[i].retired;
+        for (size_t j = 0; j < retired.size(); j++)
+            retired[j].deleter(retired[j].ptr);
+    }
+}
+
+/**
+ * Slot of the current thread, picked by hashing its id.
+ * @returns The slot index.
+ */
+inline int Reclaimer::slotOf ()
+{
+    static thread_local int slot =
+        std::hash<std::thread::id>()(std::this_thread::get_id()) % RECLAIMER_SLOTS;
+    return slot;
+}
+
+/**
+ * Registers the current thread as a reader.
+ * @returns The token to pass to exit.
+ */
+inline int Reclaimer::enter ()
+{
+    int slot = slotOf();
+    int parity = this->epoch.load() & 1;
+    this->slots[slot].count[parity].fetch_add(1);
+    guardDepth()++;
+    return (slot << 1) | parity;
+}
+
+/**
+ * Unregisters the current thread as a reader.
+ * If enough objects are retired through its slot and the
+ * thread holds no other guard, tries to free them.
+ * @param token The token returned by enter.
+ */
+inline void Reclaimer::exit (int token)
+{
+    Slot& slot = this->slots[token >> 1];
+    slot.count[token & 1].fetch_sub(1);
+    if (--guardDepth() == 0 &&
+            slot.n_retired.load(std::memory_order_relaxed) >= RECLAIMER_THRESHOLD)
+        this->tryAdvance();
+}
+
+/**
+ * Retires an object which is no longer reachable.
+ * It goes to the list of the thread's slot, so writers
+ * of different threads do not contend.
+ * @param ptr The object.
+ * @param deleter The function which frees the object.
+ */
+inline void Reclaimer::retire (void* ptr, void (*deleter)(void*))
+{
+    Slot& slot = this->slots[slotOf()];
+    // A later epoch than the one the object was unlinked
+    // in only delays freeing it.
+    Retired r = {ptr, deleter, this->epoch.load()};
+    slot.mutex.lock();
+    slot.retired.push_back(r);
+    slot.n_retired.store(slot.retired.size(), std::memory_order_relaxed);
+    slot.mutex.unlock();
+}
+
+/**
+ * Frees the objects of every slot retired at least
+ * two epochs before given epoch.
+ * @param e The epoch.
+ */
+inline void Reclaimer::collect (ULL e)
+{
+    vector<Retired> ready;
+    for (int i = 0; i < RECLAIMER_SLOTS; i++)
+    {
+        Slot& slot = this->slots[i];
+        if (slot.n_retired.load(std::memory_order_relaxed) == 0)
+            continue;
+        slot.mutex.lock();
+        size_t j = 0;
+        for (size_t k = 0; k < slot.retired.size(); k++)
+        {
+            if (slot.retired[k].epoch + 2 <= e)
+                ready.push_back(slot.retired[k]);
+            else
+                slot.retired[j++] = slot.retired[k];
+        }
+        slot.retired.resize(j);
+        slot.n_retired.store(j, std::memory_order_relaxed);
+        slot.mutex.unlock();
+    }
+    for (size_t i = 0; i < ready.size(); i++)
+        ready[i].deleter(ready[i].ptr);
+}
+
+/**
+ * Tries to advance the epoch and frees objects
+ * retired at least two epochs ago. Never blocks.
+ * @returns True if epoch was advanced else False.
+ */
+inline bool Reclaimer::tryAdvance ()
+{
+    if (!this->mutex.try_lock())
+        return false;
+    ULL e = this->epoch.load();
+    // Readers which entered in the previous epoch
+    // must have left before advancing.
+    int parity = (e + 1) & 1;
+    for (int i = 0; i < RECLAIMER_SLOTS; i++)
+    {
+        if (this->slots[i].count[parity].load() != 0)
+        {
+            this->mutex.unlock();
+            return false;
+        }
+    }
+    this->epoch.store(++e);
+    this->mutex.unlock();
+    this->collect(e);
+    return true;
+}
+
+/**
+ * Waits until every object retired before the call
+ * can be freed, and frees them.
+ * Must not be called while holding a guard.
+ */
+inline void Reclaimer::synchronize ()
+{
+    ULL target = this->epoch.load() + 2;
+    while (this->epoch.load() < target)
+    {
+        if (!this->tryAdvance())
+            std::this_thread::yield();
+    }
+    // Another thread may have advanced the epoch
+    // and not yet freed the objects.
+    this->collect(this->epoch.load());
+}
+
+/**
+ * ReclaimGuard class.
+ * Keeps retired objects alive while in scope.
+ */
+class ReclaimGuard
+{
+    /**
+     * The reclaimer.
      */
-    std::mutex      mutex;
+    Reclaimer&              reclaimer;
     /**
-     * Mutex lock for children.
+     * The token from Reclaimer::enter.
      */
-    std::mutex      child_mutex;
+    int                     token;
+    public:
     /**
-     * Mutex lock for value.
+     * ReclaimGuard constructor.
+     * @param reclaimer The reclaimer to enter.
+     */
+                            ReclaimGuard(Reclaimer& reclaimer)
+                                : reclaimer(reclaimer)
+                            {
+                                this->token = reclaimer.enter();
+                            }
+    /**
+     * ReclaimGuard destructor.
+     */
+                            ~ReclaimGuard()
+                            {
+                                this->reclaimer.exit(this->token);
+                            }
+};
+
+/**
+ * WorkStealingQueue class.
+ * Double ended task queue of a worker. The owner pushes
+ * and pops at the back, idle workers steal from the front.
+ */
+template <class Task>
+class WorkStealingQueue
+{
+    /**
+     * The tasks.
+     */
+    deque<Task>             tasks;
+    /**
+     * Mutex lock for tasks.
+     */
+    std::mutex              mutex;
+    /**
+     * Number of tasks, read without the lock.
+     */
+    std::atomic<size_t>     size;
+    public:
+                            WorkStealingQueue() : size(0) {}
+    void                    push(Task);
+    bool                    pop(Task&);
+    bool                    steal(Task&);
+    /**
+     * Checks if the queue is empty, without locking.
+     * @returns True if there are no tasks.
      */
-    std::mutex      val_mutex;
+    bool                    empty()
+                            {
+                                return this->size.load(std::memory_order_relaxed) == 0;
+                            }
+};
+
+/**
+ * Pushes a task at the back.
+ * @param task The task.
+ */
+template <class Task>
+void WorkStealingQueue<Task>::push (Task task)
+{
+    this->mutex.lock();
+    this->tasks.push_back(task);
+    this->size.store(this->tasks.size(), std::memory_order_relaxed);
+    this->mutex.unlock();
+}
+
+/**
+ * Pops a task from the back.
+ * @param task Set to the task if any.
+ * @returns True if a task was popped else False.
+ */
+template <class Task>
+bool WorkStealingQueue<Task>::pop (Task& task)
+{
+    this->mutex.lock();
+    bool found = !this->tasks.empty();
+    if (found)
+    {
+        task = this->tasks.back();
+        this->tasks.pop_back();
+        this->size.store(this->tasks.size(), std::memory_order_relaxed);
+    }
+    this->mutex.unlock();
+    return found;
+}
+
+/**
+ * Steals a task from the front.
+ * @param task Set to the task if any.
+ * @returns True if a task was stolen else False.
+ */
+template <class Task>
+bool WorkStealingQueue<Task>::steal (Task& task)
+{
+    if (!this->mutex.try_lock())
+        return false;
+    bool found = !this->tasks.empty();
+    if (found)
+    {
+        task = this->tasks.front();
+        this->tasks.pop_front();
+        this->size.store(this->tasks.size(), std::memory_order_relaxed);
+    }
+    this->mutex.unlock();
+    return found;
+}
+
+/**
+ * Counts set bits.
+ * @param x The number.
+ * @returns Number of set bits in x.
+ */
+inline int popcount (ULL x)
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(x);
+#else
+    int count = 0;
+    for (; x; x &= x - 1)
+        count++;
+    return count;
+#endif
+}
 
+/**
+ * SpinLock class.
+ * One byte lock used in place of std::mutex by compact Nodes.
+ */
+class SpinLock
+{
+    /**
+     * True while locked.
+     */
+    std::atomic<bool>       flag;
     public:
-                    Node(ULL, int, ULL, T val = NULL);
-    void            lock();
-    bool            try_lock();
-    void            unlock();
-    ULL             getKey();
-    void            setValue(T);
-    T               getValue();
-    void            setChild(int, Node*);
-    Node<T>*        getChild(int);
-    vector<int>     getCoordinates();
+    /**
+     * SpinLock constructor.
+     */
+                            SpinLock() : flag(false) {}
+    /**
+     * Locks, yielding while the lock is held by others.
+     */
+    void                    lock()
+                            {
+                                while (this->flag.exchange(true, std::memory_order_acquire))
+                                    std::this_thread::yield();
+                            }
+    /**
+     * Non blocking lock.
+     * @returns True if locked else False.
+     */
+    bool                    try_lock()
+                            {
+                                return !this->flag.exchange(true, std::memory_order_acquire);
+                            }
+    /**
+     * Unlocks.
+     */
+    void                    unlock()
+                            {
+                                this->flag.store(false, std::memory_order_release);
+                            }
 };
 
+#if defined(MDLIST_COMPACT_NODES) || defined(MDLIST_ALIGNED_NODES)
+typedef SpinLock NodeMutex;
+#else
+typedef std::mutex NodeMutex;
+#endif
+
+#ifdef MDLIST_ALIGNED_NODES
+/**
+ * NodeArena class.
+ * Allocator of cache line aligned blocks for Nodes. Memory is
+ * taken from regions aligned to ARENA_REGION_SIZE, each holding
+ * blocks of one size, so the region of a block is found from its
+ * address. A block is allocated in the region of a hint block if
+ * it has room, so children end up near their parent and their
+ * siblings. Otherwise it comes from the region the thread
+ * currently allocates from. Freed blocks are kept for reuse in
+ * their region. A region with free blocks which no thread
+ * allocates from is kept in a pool for its block size, and a
+ * region whose blocks are all free is returned to the system.
+ */
+class NodeArena
+{
+    /**
+     * Header of a region, in its first cache line.
+     */
+    struct Region
+    {
+        SpinLock        lock;
+        /**
+         * Whether a thread allocates from the region.
+         */
+        bool            owned;
+        /**
+         * Whether the region is in the pool.
+         */
+        bool            pooled;
+        /**
+         * Size of the blocks.
+         */
+        size_t          block;
+        /**
+         * Offset of the first block never allocated.
+         */
+        size_t          next;
+        /**
+         * Number of blocks allocated and not freed.
+         */
+        size_t          live;
+        /**
+         * Freed blocks, linked through their first word.
+         */
+        void*           free;
+    };
+    /**
+     * Regions a thread allocates from, one per block size.
+     * Given back to the pool when the thread exits.
+     */
+    struct Current
+    {
+        vector<Region*> regions;
+                        ~Current()
+                        {
+                            for (size_t i = 0; i < this->regions.size(); i++)
+                                release(this->regions[i]);
+                        }
+    };
+    /**
+     * Regions which have free blocks and are not owned,
+     * by block size. Guarded by poolMutex.
+     */
+    static std::map<size_t, vector<Region*> >&
+                        pool();
+    static std::mutex&  poolMutex();
+    static std::atomic<size_t>&
+                        reservedBytes();
+    static Region*      regionOf(void*);
+    static bool         hasRoom(Region*);
+    static void*        take(Region*);
+    static Region*      acquire(size_t);
+    static void         release(Region*);
+    static void         unpool(Region*);
+    public:
+    static void*        allocate(size_t, void*);
+    static void         deallocate(void*);
+    static size_t       reserved();
+};
+
+/**
+ * The pool of regions with free blocks.
+ * @returns Reference to the pool.
+ */
+inline std::map<size_t, vector<NodeArena::Region*> >& NodeArena::pool ()
+{
+    static std::map<size_t, vector<Region*> > pool;
+    return pool;
+}
+
+/**
+ * Mutex lock for the pool, and for a region changing
+ * owner or leaving the pool. Taken before region locks.
+ * @returns Reference to the mutex.
+ */
+inline std::mutex& NodeArena::poolMutex ()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+/**
+ * Bytes held in regions.
+ * @returns Reference to the counter.
+ */
+inline std::atomic<size_t>& NodeArena::reservedBytes ()
+{
+    static std::atomic<size_t> bytes(0);
+    return bytes;
+}
+
+/**
+ * Finds the region of a block.
+ * @param p The block.
+ * @returns The region.
+ */
+inline NodeArena::Region* NodeArena::regionOf (void* p)
+{
+    return (Region*) ((uintptr_t) p & ~(uintptr_t) (ARENA_REGION_SIZE - 1));
+}
+
+/**
+ * Checks if a region has a block to allocate.
+ * Must hold the region lock.
+ * @param region The region.
+ * @returns True if a block can be taken.
+ */
+inline bool NodeArena::hasRoom (Region* region)
+{
+    return region->free != NULL || region->next + region->block <= ARENA_REGION_SIZE;
+}
+
+/**
+ * Takes a free block of a region.
+ * @param region The region.
+ * @returns The block, NULL if the region is full.
+ */
+inline void* NodeArena::take (Region* region)
+{
+    region->lock.lock();
+    void* p = region->free;
+    if (p != NULL)
+        region->free = *(void**) p;
+    else if (region->next + region->block <= ARENA_REGION_SIZE)
+    {
+        p = (char*) region + region->next;
+        region->next += region->block;
+    }
+    if (p != NULL)
+        region->live++;
+    region->lock.unlock();
+    return p;
+}
+
+/**
+ * Takes a region with room from the pool, or a new one,
+ * for the current thread to allocate from.
+ * @param size Size of the blocks.
+ * @returns The region, owned by the current thread.
+ */
+inline NodeArena::Region* NodeArena::acquire (size_t size)
+{
+    poolMutex().lock();
+    vector<Region*>& pooled = pool()[size];
+    while (!pooled.empty())
+    {
+        Region* region = pooled.back();
+        pooled.pop_back();
+        region->lock.lock();
+        region->pooled = false;
+        // Hinted allocations may have filled it meanwhile,
+        // then a later free puts it back.
+        bool room = hasRoom(region);
+        region->owned = room;
+        region->lock.unlock();
+        if (room)
+        {
+            poolMutex().unlock();
+            return region;
+        }
+    }
+    poolMutex().unlock();
+    void* memory = aligned_alloc(ARENA_REGION_SIZE, ARENA_REGION_SIZE);
+    if (memory == NULL)
+        throw std::bad_alloc();
+    reservedBytes() += ARENA_REGION_SIZE;
+    Region* region = new (memory) Region();
+    region->owned = true;
+    region->pooled = false;
+    region->block = size;
+    region->next = CACHE_LINE;
+    region->live = 0;
+    region->free = NULL;
+    return region;
+}
+
+/**
+ * Gives back a region the current thread allocated from.
+ * It is freed if empty, else pooled if it has room.
+ * @param region The region.
+ */
+inline void NodeArena::release (Region* region)
+{
+    poolMutex().lock();
+    region->lock.lock();
+    region->owned = false;
+    bool empty = region->live == 0;
+    if (!empty && hasRoom(region))
+    {
+        region->pooled = true;
+        pool()[region->block].push_back(region);
+    }
+    region->lock.unlock();
+    poolMutex().unlock();
+    if (empty)
+    {
+        reservedBytes() -= ARENA_REGION_SIZE;
+        free(region);
+    }
+}
+
+/**
+ * Removes a pooled region from the pool.
+ * Must hold the pool mutex.
+ * @param region The region.
+ */
+inline void NodeArena::unpool (Region* region)
+{
+    vector<Region*>& pooled = pool()[region->block];
+    pooled.erase(std::find(pooled.begin(), pooled.end(), region));
+}
+
+/**
+ * Allocates a block.
+ * @param size Size of the block in bytes.
+ * @param hint A block to allocate near, or NULL.
+ * @returns The block, aligned to CACHE_LINE.
+ */
+inline void* NodeArena::allocate (size_t size, void* hint)
+{
+    size = (size + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    if (size > ARENA_REGION_SIZE - CACHE_LINE)
+        throw "Node is too large for NodeArena";
+    if (hint != NULL && regionOf(hint)->block == size)
+    {
+        void* p = take(regionOf(hint));
+        if (p != NULL)
+            return p;
+    }
+    static thread_local Current current;
+    vector<Region*>& regions = current.regions;
+    size_t i = 0;
+    while (i < regions.size() && regions[i]->block != size)
+        i++;
+    if (i == regions.size())
+        regions.push_back(acquire(size));
+    void* p = take(regions[i]);
+    while (p == NULL)
+    {
+        release(regions[i]);
+        regions[i] = acquire(size);
+        p = take(regions[i]);
+    }
+    return p;
+}
+
+/**
+ * Frees a block for reuse. A region no thread allocates
+ * from goes back to the pool when it gets room, and is
+ * returned to the system when it gets empty.
+ * @param p The block.
+ */
+inline void NodeArena::deallocate (void* p)
+{
+    Region* region = regionOf(p);
+    region->lock.lock();
+    if (region->owned || (region->pooled && region->live > 1))
+    {
+        *(void**) p = region->free;
+        region->free = p;
+        region->live--;
+        region->lock.unlock();
+        return;
+    }
+    region->lock.unlock();
+    // The block is still live, so the region is not freed
+    // before the pool mutex is held.
+    poolMutex().lock();
+    region->lock.lock();
+    *(void**) p = region->free;
+    region->free = p;
+    region->live--;
+    bool empty = false;
+    if (!region->owned)
+    {
+        empty = region->live == 0;
+        if (empty && region->pooled)
+            unpool(region);
+        else if (!empty && !region->pooled)
+        {
+            region->pooled = true;
+            pool()[region->block].push_back(region);
+        }
+    }
+    region->lock.unlock();
+    poolMutex().unlock();
+    if (empty)
+    {
+        reservedBytes() -= ARENA_REGION_SIZE;
+        free(region);
+    }
+}
+
+/**
+ * Getter for memory held by the arena.
+ * @returns Bytes held in regions.
+ */
+inline size_t NodeArena::reserved ()
+{
+    return reservedBytes().load();
+}
+#endif
+
+/**
+ * A single insert or remove of a multiUpdate.
+ */
+template <class T, class K = ULL>
+struct UpdateOp
+{
+    /**
+     * The key.
+     */
+    K                   key;
+    /**
+     * The value to insert, ignored for remove.
+     */
+    T                   val;
+    /**
+     * True to remove key instead of inserting it.
+     */
+    bool                remove;
+};
+
+/**
+ * Descriptor of a multiUpdate in progress.
+ * Each Node of the update is owned by the descriptor until
+ * the update is done. Once committed, readers take the value
+ * of an owned Node from the descriptor, so all the new values
+ * become visible at the same instant.
+ */
+template <class T, class K = ULL>
+struct UpdateDescriptor
+{
+    /**
+     * The operations, sorted by key.
+     */
+    vector< UpdateOp<T, K> >
+                        ops;
+    /**
+     * Set once all the Nodes are owned.
+     */
+    std::atomic<bool>   committed;
+
+    /**
+     * Value of given key after the update.
+     * @param key The key, which must be in ops.
+     * @returns The new value, NULL if key is removed.
+     */
+    T                   valueOf(K key)
+                        {
+                            size_t lo = 0, hi = this->ops.size() - 1;
+                            while (lo < hi)
+                            {
+                                size_t mid = (lo + hi) / 2;
+                                if (this->ops[mid].key < key)
+                                    lo = mid + 1;
+                                else
+                                    hi = mid;
+                            }
+                            return this->ops[lo].remove ? NULL : this->ops[lo].val;
+                        }
+};
+
+/**
+ * Node class.
+ * Each node has a key and coordinates in key space
+ * and it stores a value. It also has a mutex for
+ * thread safety in multi-threaded environment.
+ */
+template <class T, class K = ULL>
+class Node
+{
+    /**
+     * The value.
+     */
+    T               val;
+    /**
+     * Expiry time of value in steadyNanos, 0 if it
+     * does not expire. Guarded by val_mutex.
+     */
+    ULL             expiry;
+    /**
+     * Mutex lock for this Node.
+     */
+    NodeMutex       mutex;
+    /**
+     * Mutex lock for value.
+     */
+    NodeMutex       val_mutex;
+    /**
+     * The multiUpdate owning this Node, NULL if none.
+     */
+    std::atomic<UpdateDescriptor<T, K>*>
+                    owner;
+#ifdef MDLIST_ALIGNED_NODES
+    /**
+     * Fields read by traversals, starting on a new cache line
+     * after the value and locks. The block goes on past the end
+     * of the Node with the coordinates, padded to 8 bytes, and
+     * then the children, so the Node is allocated by create.
+     */
+    struct alignas(CACHE_LINE) Hot
+    {
+        K                   key;
+        /**
+         * Lowest dimension this Node may have children in.
+         * Raised when a Node is inserted above it.
+         */
+        std::atomic<int>    min_dim;
+        /**
+         * Number of coordinates and children.
+         */
+        int                 dims;
+        int                 coordinate[1];
+    };
+    Hot             hot;
+    std::atomic<Node*>*
+                    children();
+                    Node(K, const vector<int>&, T val = NULL);
+#else
+    /**
+     * The key.
+     */
+    K               key;
+    /**
+     * The Node coordinates.
+     * This is constant for a given Node.
+     */
+    vector<int>     COORDINATES;
+#ifdef MDLIST_COMPACT_NODES
+    /**
+     * Children block of a compact Node.
+     * Bit d of bitmap is set if dth child is not NULL, and
+     * the non NULL children follow in order of dimension.
+     * A block is never changed once published, setChild
+     * replaces the whole block instead.
+     */
+    struct ChildBlock
+    {
+        ULL         bitmap;
+        Node*       child[1];
+    };
+    /**
+     * The children block, NULL if there are no children.
+     */
+    std::atomic<ChildBlock*>
+                    children;
+    static ChildBlock*
+                    newChildBlock(ULL);
+    static void     deleteChildBlock(void*);
+#else
+    /**
+     * The vector of children of this Node.
+     */
+    vector<Node*>   child;
+    /**
+     * Mutex lock for children.
+     */
+    std::mutex      child_mutex;
+#endif
+    /**
+     * Lowest dimension this Node may have children in.
+     * Raised when a Node is inserted above it.
+     */
+    std::atomic<int>
+                    min_dim;
+#endif
+
+    public:
+#ifndef MDLIST_ALIGNED_NODES
+                    Node(K, int, K, T val = NULL);
+                    Node(K, const vector<int>&, T val = NULL);
+#endif
+                    ~Node();
+    static Node*    create(K, const vector<int>&, Node* hint = NULL);
+#ifdef MDLIST_ALIGNED_NODES
+    static size_t   allocationSize(int);
+    static void*    operator new(size_t) = delete;
+    static void     operator delete(void*);
+#endif
+    void            lock();
+    bool            try_lock();
+    void            unlock();
+    K               getKey();
+    void            setValue(T, ULL expiry = 0);
+    T               getValue();
+    ULL             getExpiry();
+    UpdateDescriptor<T, K>*
+                    getOwner();
+    void            setOwner(UpdateDescriptor<T, K>*);
+    void            setChild(int, Node*, Reclaimer* reclaimer = NULL);
+    void            setChild(int, int, Node*, Reclaimer*);
+    Node<T, K>*     getChild(int);
+    Node<T, K>*     getChild(int, int);
+    vector<Node*>   getChildren();
+    int             getDimensions();
+    int             getCoordinate(int, int);
+    int             getMinDimension(int);
+    void            setMinDimension(int, int);
+    vector<int>     getCoordinates();
+    vector<int>     getCoordinates(int);
+};
+
+/**
+ * Node Class Constructor.
+ * @param key The key.
+ * @param D D value of MDList.
+ * @param N The key space.
+ * @param val The value (optional).
+ */
+#ifndef MDLIST_ALIGNED_NODES
+template <class T, class K>
+Node<T, K>::Node (K key, int D, K N, T val)
+    : Node(key, keyToCoordinates(key, D, N), val)
+{
+}
+#endif
+
+/**
+ * Node Class Constructor.
+ * @param key The key.
+ * @param coordinates Coordinates of key, one per
+ *                    dimension of MDList.
+ * @param val The value (optional).
+ */
+template <class T, class K>
+Node<T, K>::Node (K key, const vector<int>& coordinates, T val)
+{
+    int D = coordinates.size();
+    this->val = val;
+    this->expiry = 0;
+    this->owner = NULL;
+#ifdef MDLIST_ALIGNED_NODES
+    // Storage past the Node was allocated by create.
+    this->hot.key = key;
+    this->hot.min_dim = 0;
+    this->hot.dims = D;
+    std::copy(coordinates.begin(), coordinates.end(), this->hot.coordinate);
+    std::atomic<Node*>* children = this->children();
+    for (int d = 0; d < D; d++)
+        new (&children[d]) std::atomic<Node*>(NULL);
+#else
+    this->key = key;
+    this->COORDINATES = coordinates;
+    this->min_dim = 0;
+#endif
+#ifdef MDLIST_COMPACT_NODES
+    if (D > 64)
+        throw "D must be at most 64 for compact nodes";
+    this->children = NULL;
+#elif !defined(MDLIST_ALIGNED_NODES)
+    this->child.assign(D, NULL);
+#endif
+}
+
+/**
+ * Creates a Node.
+ * @param key The key.
+ * @param coordinates Coordinates of key, one per
+ *                    dimension of MDList.
+ * @param hint A Node to allocate near, e.g. the parent,
+ *             or NULL (optional).
+ * @returns The Node, to be freed with delete.
+ */
+template <class T, class K>
+Node<T, K>* Node<T, K>::create (K key, const vector<int>& coordinates, Node* hint)
+{
+#ifdef MDLIST_ALIGNED_NODES
+    void* p = NodeArena::allocate(allocationSize(coordinates.size()), hint);
+    return ::new (p) Node(key, coordinates);
+#else
+    (void) hint;
+    return new Node(key, coordinates);
+#endif
+}
+
+/**
+ * Node Class Destructor.
+ */
+template <class T, class K>
+Node<T, K>::~Node ()
+{
+#ifdef MDLIST_COMPACT_NODES
+    deleteChildBlock(this->children.load());
+#endif
+}
+
+#ifdef MDLIST_ALIGNED_NODES
+/**
+ * Size of a Node with given number of dimensions, including
+ * the coordinates and children following it.
+ * @param D Number of dimensions.
+ * @returns The size in bytes.
+ */
+template <class T, class K>
+size_t Node<T, K>::allocationSize (int D)
+{
+    size_t coordinates = (D * sizeof(int) + 7) / 8 * 8;
+    return offsetof(Node, hot) + offsetof(Hot, coordinate) + coordinates +
+           D * sizeof(std::atomic<Node*>);
+}
+
+/**
+ * Getter for the children, which follow the coordinates.
+ * @returns The first child.
+ */
+template <class T, class K>
+std::atomic<Node<T, K>*>* Node<T, K>::children ()
+{
+    size_t coordinates = (this->hot.dims * sizeof(int) + 7) / 8 * 8;
+    return (std::atomic<Node*>*) ((char*) this->hot.coordinate + coordinates);
+}
+
+/**
+ * Frees a Node allocated by create.
+ * @param p The Node.
+ */
+template <class T, class K>
+void Node<T, K>::operator delete (void* p)
+{
+    NodeArena::deallocate(p);
+}
+#endif
+
+#ifdef MDLIST_COMPACT_NODES
+/**
+ * Allocates a children block sized for given bitmap.
+ * @param bitmap The occupancy bitmap.
+ * @returns The block, NULL if bitmap is empty.
+ */
+template <class T, class K>
+typename Node<T, K>::ChildBlock* Node<T, K>::newChildBlock (ULL bitmap)
+{
+    if (bitmap == 0)
+        return NULL;
+    size_t size = sizeof(ChildBlock) + (popcount(bitmap) - 1) * sizeof(Node*);
+    ChildBlock* block = (ChildBlock*) ::operator new(size);
+    block->bitmap = bitmap;
+    return block;
+}
+
+/**
+ * Frees a children block.
+ * Used as Reclaimer deleter.
+ * @param block The block.
+ */
+template <class T, class K>
+void Node<T, K>::deleteChildBlock (void* block)
+{
+    ::operator delete(block);
+}
+#endif
+
+/**
+ * Locks the node mutex.
+ */
+template <class T, class K>
+void Node<T, K>::lock () 
+{
+    this->mutex.lock();
+}
+
+/**
+ * Non blocking lock operation on node mutex.
+ * @returns True if locked else False.
+ */
+template <class T, class K>
+bool Node<T, K>::try_lock ()
+{
+    return this->mutex.try_lock();
+}
+
+/**
+ * Unlocks the node mutex.
+ */
+template <class T, class K>
+void Node<T, K>::unlock ()
+{
+    this->mutex.unlock();
+}
+
+/**
+ * Getter for key
+ * @returns The key of Node.
+ */
+template <class T, class K>
+K Node<T, K>::getKey ()
+{
+    // Constant so no need for lock
+#ifdef MDLIST_ALIGNED_NODES
+    return this->hot.key;
+#else
+    return this->key;
+#endif
+}
+
+/**
+ * Setter for value.
+ * @param val The value.
+ * @param expiry Expiry time in steadyNanos, 0 if the
+ *               value does not expire (optional).
+ */
+template <class T, class K>
+void Node<T, K>::setValue (T val, ULL expiry)
+{
+    this->val_mutex.lock();
+    this->val = val;
+    this->expiry = expiry;
+    this->val_mutex.unlock();
+}
+
+/**
+ * Getter for Value.
+ * If a committed multiUpdate owns the Node, its value
+ * is taken from the update.
+ * @returns The value, NULL if it has expired.
+ */
+template <class T, class K>
+T Node<T, K>::getValue ()
+{
+    UpdateDescriptor<T, K>* owner = this->owner.load();
+    if (owner != NULL && owner->committed.load())
+        return owner->valueOf(this->getKey());
+    this->val_mutex.lock();
+    T t = this->val;
+    ULL expiry = this->expiry;
+    this->val_mutex.unlock();
+    if (expiry != 0 && steadyNanos() >= expiry)
+        return NULL;
+    return t;
+}
+
+/**
+ * Getter for expiry time.
+ * @returns Expiry time of value in steadyNanos,
+ *          0 if it does not expire.
+ */
+template <class T, class K>
+ULL Node<T, K>::getExpiry ()
+{
+    this->val_mutex.lock();
+    ULL expiry = this->expiry;
+    this->val_mutex.unlock();
+    return expiry;
+}
+
+/**
+ * Getter for owner.
+ * @returns The multiUpdate owning this Node, NULL if none.
+ */
+template <class T, class K>
+UpdateDescriptor<T, K>* Node<T, K>::getOwner ()
+{
+    return this->owner.load();
+}
+
+/**
+ * Setter for owner.
+ * Called with the Node locked.
+ * @param owner The multiUpdate, NULL to release the Node.
+ */
+template <class T, class K>
+void Node<T, K>::setOwner (UpdateDescriptor<T, K>* owner)
+{
+    this->owner.store(owner);
+}
+
+/**
+ * Setter for child Node.
+ * @param index The index of Child.
+ * @param childNode The child Node.
+ * @param reclaimer Reclaimer to retire replaced memory to, if
+ *                  the Node may be read concurrently (optional).
+ */
+template <class T, class K>
+void Node<T, K>::setChild (int index, Node* childNode, Reclaimer* reclaimer)
+{
+    if (index < 0 || index >= this->getDimensions())
+        throw "Index out of bounds";
+#ifdef MDLIST_COMPACT_NODES
+    // Copy on write, so readers never see a block being changed.
+    ULL bit = 1ULL << index;
+    ChildBlock* old = this->children.load();
+    ChildBlock* block;
+    do
+    {
+        ULL bitmap = old == NULL ? 0 : old->bitmap;
+        ULL new_bitmap = childNode == NULL ? bitmap & ~bit : bitmap | bit;
+        block = newChildBlock(new_bitmap);
+        // Copy children with the new one in place.
+        for (int d = 0, i = 0, j = 0; d < 64 && (bitmap | new_bitmap) >> d; d++)
+        {
+            Node* node = (bitmap >> d & 1) ? old->child[i++] : NULL;
+            if (d == index)
+                node = childNode;
+            if (node != NULL)
+                block->child[j++] = node;
+        }
+        if (this->children.compare_exchange_weak(old, block))
+            break;
+        deleteChildBlock(block);
+    } while (true);
+    if (old == NULL)
+        return;
+    if (reclaimer != NULL)
+        reclaimer->retire(old, deleteChildBlock);
+    else
+        deleteChildBlock(old);
+#elif defined(MDLIST_ALIGNED_NODES)
+    (void) reclaimer;
+    this->children()[index].store(childNode);
+#else
+    (void) reclaimer;
+    this->child_mutex.lock();
+    this->child[index] = childNode;
+    this->child_mutex.unlock();
+#endif
+}
+
+/**
+ * Getter for Child.
+ * @param index The index of child.
+ * @returns The child.
+ */
+template <class T, class K>
+Node<T, K>* Node<T, K>::getChild (int index)
+{
+    if (index < 0 || index >= this->getDimensions())
+        throw "Index out of bounds";
+#ifdef MDLIST_COMPACT_NODES
+    ChildBlock* block = this->children.load();
+    if (block == NULL || !(block->bitmap >> index & 1))
+        return NULL;
+    return block->child[popcount(block->bitmap & ((1ULL << index) - 1))];
+#elif defined(MDLIST_ALIGNED_NODES)
+    return this->children()[index].load();
+#else
+    this->child_mutex.lock();
+    Node<T, K>* node = this->child[index];
+    this->child_mutex.unlock();
+    return node;
+#endif
+}
+
+/**
+ * Getter for all children at once.
+ * @returns Snapshot of the children.
+ */
+template <class T, class K>
+vector<Node<T, K>*> Node<T, K>::getChildren ()
+{
+#ifdef MDLIST_COMPACT_NODES
+    vector<Node<T, K>*> children(this->getDimensions(), NULL);
+    ChildBlock* block = this->children.load();
+    if (block == NULL)
+        return children;
+    for (int d = 0, i = 0; d < (int) children.size(); d++)
+        if (block->bitmap >> d & 1)
+            children[d] = block->child[i++];
+    return children;
+#elif defined(MDLIST_ALIGNED_NODES)
+    vector<Node<T, K>*> children(this->getDimensions());
+    for (int d = 0; d < (int) children.size(); d++)
+        children[d] = this->children()[d].load();
+    return children;
+#else
+    this->child_mutex.lock();
+    vector<Node<T, K>*> children = this->child;
+    this->child_mutex.unlock();
+    return children;
+#endif
+}
+
+/**
+ * Getter for Node coordinates.
+ * @returns The Node coordinates.
+ */
+template <class T, class K>
+vector<int> Node<T, K>::getCoordinates ()
+{
+#ifdef MDLIST_ALIGNED_NODES
+    return vector<int>(this->hot.coordinate, this->hot.coordinate + this->hot.dims);
+#else
+    return this->COORDINATES;
+#endif
+}
+
+/**
+ * Getter for number of dimensions of the key space
+ * this Node was created in.
+ * @returns The number of dimensions.
+ */
+template <class T, class K>
+int Node<T, K>::getDimensions ()
+{
+#ifdef MDLIST_ALIGNED_NODES
+    return this->hot.dims;
+#else
+    return this->COORDINATES.size();
+#endif
+}
+
+// A key space grows by adding leading dimensions, so a Node
+// created in a smaller key space has leading coordinates 0 and
+// no children in them. The accessors below take dimension d of
+// the current D dimensional key space.
+
+/**
+ * Getter for a coordinate in a D dimensional key space.
+ * @param d The dimension.
+ * @param D Number of dimensions of key space.
+ * @returns The coordinate.
+ */
+template <class T, class K>
+int Node<T, K>::getCoordinate (int d, int D)
+{
+    int offset = D - this->getDimensions();
+    if (d < offset)
+        return 0;
+#ifdef MDLIST_ALIGNED_NODES
+    return this->hot.coordinate[d - offset];
+#else
+    return this->COORDINATES[d - offset];
+#endif
+}
+
+/**
+ * Getter for Node coordinates in a D dimensional key space.
+ * @param D Number of dimensions of key space.
+ * @returns The Node coordinates.
+ */
+template <class T, class K>
+vector<int> Node<T, K>::getCoordinates (int D)
+{
+    vector<int> coordinates(D);
+    for (int d = 0; d < D; d++)
+        coordinates[d] = this->getCoordinate(d, D);
+    return coordinates;
+}
+
+/**
+ * Getter for Child in a D dimensional key space.
+ * @param d The dimension of child.
+ * @param D Number of dimensions of key space.
+ * @returns The child.
+ */
+template <class T, class K>
+Node<T, K>* Node<T, K>::getChild (int d, int D)
+{
+    int offset = D - this->getDimensions();
+    return d < offset ? NULL : this->getChild(d - offset);
+}
+
+/**
+ * Getter for lowest dimension of children in a D dimensional
+ * key space. A traversal which reads a child below it reached
+ * this Node before a Node was inserted above it.
+ * @param D Number of dimensions of key space.
+ * @returns The dimension.
+ */
+template <class T, class K>
+int Node<T, K>::getMinDimension (int D)
+{
+#ifdef MDLIST_ALIGNED_NODES
+    return this->hot.min_dim.load() + D - this->getDimensions();
+#else
+    return this->min_dim.load() + D - this->getDimensions();
+#endif
+}
+
+/**
+ * Setter for lowest dimension of children in a D dimensional
+ * key space.
+ * @param d The dimension.
+ * @param D Number of dimensions of key space.
+ */
+template <class T, class K>
+void Node<T, K>::setMinDimension (int d, int D)
+{
+#ifdef MDLIST_ALIGNED_NODES
+    this->hot.min_dim.store(max(d - (D - this->getDimensions()), 0));
+#else
+    this->min_dim.store(max(d - (D - this->getDimensions()), 0));
+#endif
+}
+
+/**
+ * Setter for child Node in a D dimensional key space.
+ * @param d The dimension of child.
+ * @param D Number of dimensions of key space.
+ * @param childNode The child Node.
+ * @param reclaimer Reclaimer to retire replaced memory to.
+ */
+template <class T, class K>
+void Node<T, K>::setChild (int d, int D, Node* childNode, Reclaimer* reclaimer)
+{
+    int offset = D - this->getDimensions();
+    if (d >= offset)
+        this->setChild(d - offset, childNode, reclaimer);
+    else if (childNode != NULL)
+        throw "Index out of bounds";
+}
+
+/**
+ * Frees a Node and all Nodes below it.
+ * Used as Reclaimer deleter for detached subtrees.
+ * @param p The root Node of the subtree.
+ */
+template <class T, class K>
+void destroySubtree (void* p)
+{
+    vector< Node<T, K>* > stack(1, (Node<T, K>*) p);
+    while (stack.size() > 0)
+    {
+        Node<T, K>* node = stack.back();
+        stack.pop_back();
+        vector< Node<T, K>* > children = node->getChildren();
+        for (size_t d = 0; d < children.size(); d++)
+            if (children[d] != NULL)
+                stack.push_back(children[d]);
+        delete node;
+    }
+}
+
+/**
+ * LookupCache class.
+ * Fixed size, direct mapped, lock free cache from key to Node.
+ * Each slot is guarded by a version: odd while being written,
+ * and bumped by every invalidation. A slot is only filled if its
+ * version did not change since before the traversal that found
+ * the Node, so a Node removed meanwhile is never cached.
+ */
+template <class T, class K = ULL>
+class LookupCache
+{
+    /**
+     * A cache slot.
+     */
+    struct Slot
+    {
+        std::atomic<ULL>        version;
+        std::atomic<Node<T, K>*>
+                                node;
+    };
+    /**
+     * Hit and miss counters, padded to a cache line.
+     */
+    struct alignas(64) Counter
+    {
+        std::atomic<ULL>        hits;
+        std::atomic<ULL>        misses;
+    };
+    /**
+     * The slots, a power of two in number.
+     */
+    vector<Slot>                slots;
+    /**
+     * Number of slots minus one.
+     */
+    ULL                         mask;
+    /**
+     * Counters striped by thread.
+     */
+    Counter                     counters[CACHE_COUNTER_SLOTS];
+
+    Slot&                       slot(K);
+    Counter&                    counter();
+    void                        invalidateSlot(Slot&);
+    public:
+                                LookupCache(size_t);
+    static LookupCache*         create(size_t);
+    static void                 destroy(LookupCache*);
+    Node<T, K>*                 lookup(K, ULL&);
+    void                        fill(K, ULL, Node<T, K>*);
+    void                        invalidate(K);
+    void                        invalidateAll();
+    ULL                         hits();
+    ULL                         misses();
+};
+
+/**
+ * LookupCache constructor.
+ * @param size Number of slots, rounded up to a power of two.
+ */
+template <class T, class K>
+LookupCache<T, K>::LookupCache (size_t size)
+{
+    size_t n = 1;
+    while (n < size)
+        n <<= 1;
+    this->slots = vector<Slot>(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        this->slots[i].version = 0;
+        this->slots[i].node = NULL;
+    }
+    this->mask = n - 1;
+    for (int i = 0; i < CACHE_COUNTER_SLOTS; i++)
+    {
+        this->counters[i].hits = 0;
+        this->counters[i].misses = 0;
+    }
+}
+
+/**
+ * Allocates a LookupCache aligned for its counters,
+ * which plain new does not guarantee before C++17.
+ * @param size Number of slots, rounded up to a power of two.
+ * @returns The LookupCache.
+ */
+template <class T, class K>
+LookupCache<T, K>* LookupCache<T, K>::create (size_t size)
+{
+    void* memory = aligned_alloc(alignof(LookupCache), sizeof(LookupCache));
+    if (memory == NULL)
+        throw std::bad_alloc();
+    try
+    {
+        return new (memory) LookupCache(size);
+    }
+    catch (...)
+    {
+        free(memory);
+        throw;
+    }
+}
+
+/**
+ * Frees a LookupCache allocated by create.
+ * @param cache The LookupCache, can be NULL.
+ */
+template <class T, class K>
+void LookupCache<T, K>::destroy (LookupCache* cache)
+{
+    if (cache == NULL)
+        return;
+    cache->~LookupCache();
+    free(cache);
+}
+
+/**
+ * Finds the slot of a key.
+ * @param key The key.
+ * @returns The slot.
+ */
+template <class T, class K>
+typename LookupCache<T, K>::Slot& LookupCache<T, K>::slot (K key)
+{
+    ULL folded = 0;
+    for (size_t i = 0; i < sizeof(K); i += sizeof(ULL))
+        folded ^= (ULL) (key >> (8 * i));
+    // Fibonacci hashing spreads consecutive keys.
+    ULL hash = folded * 0x9E3779B97F4A7C15ULL;
+    return this->slots[(hash >> 32) & this->mask];
+}
+
+/**
+ * Finds the counter of current thread.
+ * @returns The counter.
+ */
+template <class T, class K>
+typename LookupCache<T, K>::Counter& LookupCache<T, K>::counter ()
+{
+    size_t hash = std::hash<std::thread::id>()(std::this_thread::get_id());
+    return this->counters[hash % CACHE_COUNTER_SLOTS];
+}
+
+/**
+ * Looks up a key.
+ * Must be called inside a ReclaimGuard, which keeps
+ * the returned Node alive.
+ * @param key The key.
+ * @param version Set to the version of slot, to pass to
+ *                fill on a miss.
+ * @returns The Node if cached else NULL.
+ */
+template <class T, class K>
+Node<T, K>* LookupCache<T, K>::lookup (K key, ULL& version)
+{
+    Slot& s = this->slot(key);
+    version = s.version.load();
+    if (!(version & 1))
+    {
+        // A Node in the slot is not retired before the slot is
+        // invalidated, so the guard keeps it alive to read its key.
+        Node<T, K>* node = s.node.load();
+        if (node != NULL && node->getKey() == key && s.version.load() == version)
+        {
+            this->counter().hits.fetch_add(1, std::memory_order_relaxed);
+            return node;
+        }
+    }
+    this->counter().misses.fetch_add(1, std::memory_order_relaxed);
+    return NULL;
+}
+
+/**
+ * Caches the Node of a key.
+ * Does nothing if the slot changed since lookup.
+ * @param key The key.
+ * @param version The version returned by lookup.
+ * @param node The Node.
+ */
+template <class T, class K>
+void LookupCache<T, K>::fill (K key, ULL version, Node<T, K>* node)
+{
+    if (version & 1)
+        return;
+    Slot& s = this->slot(key);
+    if (!s.version.compare_exchange_strong(version, version + 1))
+        return;
+    s.node.store(node);
+    s.version.store(version + 2);
+}
+
+/**
+ * Drops the slot of a key.
+ * Must be called after the Node is unlinked and before
+ * it is retired.
+ * @param key The key.
+ */
+template <class T, class K>
+void LookupCache<T, K>::invalidate (K key)
+{
+    this->invalidateSlot(this->slot(key));
+}
+
+/**
+ * Drops a slot and bumps its version.
+ * @param s The slot.
+ */
+template <class T, class K>
+void LookupCache<T, K>::invalidateSlot (Slot& s)
+{
+    ULL version = s.version.load();
+    while (true)
+    {
+        if (version & 1)
+        {
+            std::this_thread::yield();
+            version = s.version.load();
+        }
+        else if (s.version.compare_exchange_weak(version, version + 1))
+            break;
+    }
+    s.node.store(NULL);
+    s.version.store(version + 2);
+}
+
+/**
+ * Drops all slots.
+ * Used when whole subtrees are unlinked.
+ */
+template <class T, class K>
+void LookupCache<T, K>::invalidateAll ()
+{
+    for (size_t i = 0; i < this->slots.size(); i++)
+        this->invalidateSlot(this->slots[i]);
+}
+
+/**
+ * Getter for number of hits.
+ * @returns The number of hits.
+ */
+template <class T, class K>
+ULL LookupCache<T, K>::hits ()
+{
+    ULL total = 0;
+    for (int i = 0; i < CACHE_COUNTER_SLOTS; i++)
+        total += this->counters[i].hits.load();
+    return total;
+}
+
+/**
+ * Getter for number of misses.
+ * @returns The number of misses.
+ */
+template <class T, class K>
+ULL LookupCache<T, K>::misses ()
+{
+    ULL total = 0;
+    for (int i = 0; i < CACHE_COUNTER_SLOTS; i++)
+        total += this->counters[i].misses.load();
+    return total;
+}
+
+/**
+ * ExpiryWheel class.
+ * Hashed timer wheel of (key, expiry time) entries. An entry
+ * goes to the slot of the tick its expiry time falls in, and
+ * the slots of past ticks are drained in turn, so removing
+ * expired entries costs a bounded amount per call. Entries
+ * expiring more than a revolution ahead stay in their slot
+ * until a later turn.
+ */
+template <class K = ULL>
+class ExpiryWheel
+{
+    /**
+     * Entries of a slot.
+     */
+    struct Slot
+    {
+        std::mutex              mutex;
+        vector< pair<K, ULL> >
+                                entries;
+    };
+    /**
+     * The slots.
+     */
+    Slot                        slots[EXPIRY_WHEEL_SLOTS];
+    /**
+     * Next tick to drain.
+     */
+    std::atomic<ULL>            cursor;
+    /**
+     * Mutex lock for draining.
+     */
+    std::mutex                  drain_mutex;
+
+    public:
+                                ExpiryWheel();
+    void                        add(K, ULL);
+    bool                        due(ULL);
+    void                        collect(ULL, vector< pair<K, ULL> >&, size_t);
+};
+
+/**
+ * ExpiryWheel constructor.
+ */
+template <class K>
+ExpiryWheel<K>::ExpiryWheel ()
+{
+    this->cursor = steadyNanos() / EXPIRY_WHEEL_TICK;
+}
+
+/**
+ * Adds an entry.
+ * @param key The key.
+ * @param expiry Expiry time in steadyNanos.
+ */
+template <class K>
+void ExpiryWheel<K>::add (K key, ULL expiry)
+{
+    while (true)
+    {
+        ULL tick = max(expiry / EXPIRY_WHEEL_TICK, this->cursor.load());
+        Slot& slot = this->slots[tick % EXPIRY_WHEEL_SLOTS];
+        slot.mutex.lock();
+        // The cursor moves past a slot with the slot locked, so
+        // an entry is never left behind in a drained slot.
+        if (this->cursor.load() <= tick)
+        {
+            slot.entries.push_back(make_pair(key, expiry));
+            slot.mutex.unlock();
+            return;
+        }
+        slot.mutex.unlock();
+    }
+}
+
+/**
+ * Checks if there is a slot to drain.
+ * @param now Current time in steadyNanos.
+ * @returns True if collect has work to do.
+ */
+template <class K>
+bool ExpiryWheel<K>::due (ULL now)
+{
+    return now / EXPIRY_WHEEL_TICK > this->cursor.load();
+}
+
+/**
+ * Takes expired entries from the slots of past ticks.
+ * Returns at once if another thread is collecting.
+ * @param now Current time in steadyNanos.
+ * @param expired Expired (key, expiry) entries are added here.
+ * @param max_entries Most entries to take.
+ */
+template <class K>
+void ExpiryWheel<K>::collect (ULL now, vector< pair<K, ULL> >& expired,
+                              size_t max_entries)
+{
+    if (!this->drain_mutex.try_lock())
+        return;
+    ULL tick = now / EXPIRY_WHEEL_TICK;
+    ULL cursor = this->cursor.load();
+    // After a long idle time, one turn drains every slot.
+    if (tick > cursor + EXPIRY_WHEEL_SLOTS)
+        cursor = tick - EXPIRY_WHEEL_SLOTS;
+    bool full = false;
+    while (cursor < tick && !full)
+    {
+        Slot& slot = this->slots[cursor % EXPIRY_WHEEL_SLOTS];
+        slot.mutex.lock();
+        vector< pair<K, ULL> > kept;
+        for (size_t i = 0; i < slot.entries.size(); i++)
+        {
+            if (slot.entries[i].second > now)
+                kept.push_back(slot.entries[i]);
+            else if (expired.size() < max_entries)
+                expired.push_back(slot.entries[i]);
+            else
+            {
+                kept.push_back(slot.entries[i]);
+                full = true;
+            }
+        }
+        slot.entries.swap(kept);
+        if (!full)
+            cursor++;
+        this->cursor.store(cursor);
+        slot.mutex.unlock();
+    }
+    this->drain_mutex.unlock();
+}
+
+/**
+ * Key codecs.
+ * A key codec maps keys of type Key one to one to codes of
+ * unsigned integer type Code, usually ULL, such that
+ * a < b if and only if encode(a) < encode(b), and
+ * decode is the inverse of encode. MDList stores codes, so
+ * the order of keys is the order of the key space, and
+ * eraseRange works on ranges of keys. Codes are usually
+ * large, e.g. 0 of a signed key is 2^63, which makes the
+ * key space grow to the full 64 bits.
+ */
+
+/**
+ * Key codec for unsigned integers, the default.
+ * Codes are the keys themselves.
+ */
+struct UnsignedCodec
+{
+    typedef ULL         Key;
+    typedef ULL         Code;
+    static ULL          encode(ULL key)
+                        {
+                            return key;
+                        }
+    static ULL          decode(ULL code)
+                        {
+                            return code;
+                        }
+};
+
+/**
+ * Key codec for signed integers of up to 64 bits.
+ * The sign bit of the key is flipped, so negative
+ * keys come before non negative ones.
+ */
+template <class I>
+struct SignedCodec
+{
+    static_assert(std::is_integral<I>::value && std::is_signed<I>::value &&
+                  sizeof(I) <= sizeof(ULL), "SignedCodec needs a signed integer");
+    typedef I           Key;
+    typedef ULL         Code;
+    typedef typename std::make_unsigned<I>::type
+                        Unsigned;
+    static const ULL    SIGN = 1ULL << (8 * sizeof(I) - 1);
+    static ULL          encode(I key)
+                        {
+                            return (ULL) (Unsigned) key ^ SIGN;
+                        }
+    static I            decode(ULL code)
+                        {
+                            return (I) (Unsigned) (code ^ SIGN);
+                        }
+};
+
+/**
+ * Key codec for IEEE 754 doubles.
+ * The bits of a non negative key get the sign bit set, and
+ * the bits of a negative key are inverted, so codes of
+ * negative keys decrease with magnitude. -0.0 comes just
+ * before 0.0. NaN is not a valid key.
+ */
+struct DoubleCodec
+{
+    typedef double      Key;
+    typedef ULL         Code;
+    static const ULL    SIGN = 1ULL << 63;
+    static ULL          encode(double key)
+                        {
+                            if (key != key)
+                                throw "NaN is not a valid key";
+                            ULL bits;
+                            memcpy(&bits, &key, sizeof(bits));
+                            return (bits & SIGN) ? ~bits : bits | SIGN;
+                        }
+    static double       decode(ULL code)
+                        {
+                            ULL bits = (code & SIGN) ? code & ~SIGN : ~code;
+                            double key;
+                            memcpy(&key, &bits, sizeof(key));
+                            return key;
+                        }
+};
+
+#ifdef __SIZEOF_INT128__
+/**
+ * Key codec for unsigned 128 bit integers.
+ * Codes are the keys themselves, and the key space grows
+ * past 64 bits to hold them.
+ */
+struct UInt128Codec
+{
+    typedef unsigned __int128
+                        Key;
+    typedef unsigned __int128
+                        Code;
+    static Code         encode(Key key)
+                        {
+                            return key;
+                        }
+    static Key          decode(Code code)
+                        {
+                            return code;
+                        }
+};
+
+/**
+ * Key codec for signed 128 bit integers.
+ * The sign bit of the key is flipped, as in SignedCodec.
+ */
+struct Int128Codec
+{
+    typedef __int128    Key;
+    typedef unsigned __int128
+                        Code;
+    static Code         encode(Key key)
+                        {
+                            return (Code) key ^ (Code) 1 << 127;
+                        }
+    static Key          decode(Code code)
+                        {
+                            return (Key) (code ^ (Code) 1 << 127);
+                        }
+};
+#endif
+
+/**
+ * Sum of given numbers.
+ * @returns The sum.
+ */
+inline constexpr int sumOf ()
+{
+    return 0;
+}
+
+template <class... Rest>
+inline constexpr int sumOf (int first, Rest... rest)
+{
+    return first + sumOf(rest...);
+}
+
+/**
+ * Key codec for composite keys of unsigned fields, ordered
+ * by the first field, then the second, and so on. Field i
+ * takes Bits[i] bits of the code, e.g. (tenant, id) keys
+ * with 16 bit tenants and 48 bit ids use
+ * CompositeCodec<16, 48>, and keys are written {tenant, id}.
+ */
+template <int... Bits>
+struct CompositeCodec
+{
+    static_assert(sizeof...(Bits) > 0 && sumOf(Bits...) <= 64,
+                  "CompositeCodec fields must fit in 64 bits");
+    static const int    FIELDS = sizeof...(Bits);
+    typedef std::array<ULL, sizeof...(Bits)>
+                        Key;
+    typedef ULL         Code;
+    static int          width(int i)
+                        {
+                            static const int BITS[] = {Bits...};
+                            return BITS[i];
+                        }
+    static ULL          encode(const Key& key)
+                        {
+                            ULL code = 0;
+                            for (int i = 0; i < FIELDS; i++)
+                            {
+                                int w = width(i);
+                                if (w < 64 && key[i] >> w != 0)
+                                    throw "Key field does not fit in its bits";
+                                code = w < 64 ? code << w | key[i] : key[i];
+                            }
+                            return code;
+                        }
+    static Key          decode(ULL code)
+                        {
+                            Key key;
+                            for (int i = FIELDS - 1; i >= 0; i--)
+                            {
+                                int w = width(i);
+                                key[i] = w < 64 ? code & ((1ULL << w) - 1) : code;
+                                code = w < 64 ? code >> w : 0;
+                            }
+                            return key;
+                        }
+};
+
+/**
+ * MDList class
+ * MDList is a dictionary based datastruture which stores 
+ * (key, value) pairs. It has a root node. Opoerations performed
+ * on a MDList are insert, find, remove.
+ * MDList is Lock-Free datastructure, so it is thread safe.
+ * Keys are mapped to the key space by Codec, see UnsignedCodec.
+ */
+template <class T, class Codec = UnsignedCodec>
+class MDList
+{
+    /**
+     * Type of codes, see Codec.
+     */
+    typedef typename Codec::Code Code;
+    /**
+     * The key space, replaced as a whole when it grows.
+     */
+    struct Space
+    {
+        /**
+         * The D value of MDList.
+         */
+        int                     D;
+        /**
+         * The key space, 0 if it holds every Code.
+         */
+        Code                    N;
+        /**
+         * Head or Root of the MDList.
+         */
+        Node<T, Code>*          root;
+
+        /**
+         * Checks if key is in the key space.
+         * @param key The key.
+         * @returns True if key is in the key space.
+         */
+        bool                    contains(Code key)
+                                {
+                                    return this->N == 0 || key < this->N;
+                                }
+    };
+    /**
+     * The current key space.
+     */
+    std::atomic<Space*>         space;
+    /**
+     * Range of a coordinate, fixed as the key space grows.
+     */
+    ULL                         M;
+    /**
+     * Number of dimensions of points, the D value the MDList
+     * was built with. As the key space grows, points take its
+     * trailing dimensions, so they keep their keys.
+     */
+    int                         pointD;
+    /**
+     * Mutex lock for growing the key space.
+     */
+    std::mutex                  grow_mutex;
+    /**
+     * Reclaimer for removed Nodes.
+     */
+    Reclaimer                   reclaimer;
+    /**
+     * Cache of hot keys, NULL if disabled.
+     */
+    LookupCache<T, Code>*       cache;
+    /**
+     * Expiry times, NULL until a value with a TTL is inserted.
+     */
+    std::atomic<ExpiryWheel<Code>*>   wheel;
+    /**
+     * Maximum number of Nodes, 0 for no limit.
+     */
+    std::atomic<ULL>            capacity;
+    /**
+     * Number of Nodes other than root, counted
+     * while capacity is set.
+     */
+    std::atomic<long>           n_nodes;
+    pair<Node<T, Code>*, Node<T, Code>*>    locatePredecessor(Space*, vector<int>);
+    bool                        fits(Code);
+    void                        grow(Code);
+    Node<T, Code>*              insertNode(Code, T, UpdateDescriptor<T, Code>*,
+                                           ULL expiry = 0);
+    T                           removeNode(Code, UpdateDescriptor<T, Code>*,
+                                           ULL expiry = 0);
+    void                        maintain();
+    void                        sampleNodes(Space*, vector<Node<T, Code>*>&);
+    bool                        evict();
+    long                        countNodes(vector<Node<T, Code>*>);
+    static int                  workers(int);
+    template <class S, class F>
+    void                        parallelVisit(vector<Node<T, Code>*>, vector<S>&, F);
+    Code                        pointToKey(const vector<int>&);
+    void                        insertCode(Code, T);
+    T                           findCode(Code);
+    T                           removeCode(Code);
+    public:
+    /**
+     * Type of keys.
+     */
+    typedef typename Codec::Key Key;
+                                MDList(int, Code);
+                                MDList(const MDList&) = delete;
+    MDList&                     operator=(const MDList&) = delete;
+                                ~MDList();
+    void                        insert(Key, T);
+    void                        insert(Key, T, std::chrono::milliseconds);
+    T                           find(Key);
+    T                           remove(Key);
+    vector<T>                   multiUpdate(vector< UpdateOp<T, Key> >);
+    void                        clear(int threads = 0);
+    void                        eraseRange(Key, Key);
+    void                        enableCache(size_t);
+    void                        expire();
+    void                        setCapacity(ULL);
+    void                        setByteBudget(ULL);
+    ULL                         cacheHits();
+    ULL                         cacheMisses();
+    int                         getD();
+    Code                        getN();
+    void                        insertPoint(const vector<int>&, T);
+    T                           findPoint(const vector<int>&);
+    T                           removePoint(const vector<int>&);
+    vector< pair<vector<int>, T> >
+                                rangeQuery(const vector<int>&,
+                                           const vector<int>&);
+    vector< pair<vector<int>, T> >
+                                nearest(const vector<int>&, int);
+    template <class F>
+    void                        parallel_for_each(F, int threads = 0);
+    template <class R, class Map, class Combine>
+    R                           parallel_reduce(R, Map, Combine,
+                                                int threads = 0);
+    template <class _T, class _Codec>
+    friend void                 printMDList(MDList<_T, _Codec>&);
+    template <class _T, class _Codec>
+    friend void                 findAndPrint(MDList<_T, _Codec>&,
+                                             typename _Codec::Key);
+};
+
+/**
+ * MDList constructor.
+ * The key space is rounded up to M to the power D, where M is
+ * the range of a coordinate. Inserting a larger key grows the
+ * key space by adding dimensions of the same range, until it
+ * holds every Code.
+ * @param D The D value of MDList.
+ * @param N The initial key space.
+ */
+template <class T, class Codec>
+MDList<T, Codec>::MDList (int D, Code N)
+{
+    this->M = max(nthRoot(N, D), 2L);
+    if (keySpaceSize<Code>(this->M, D) != 0 && keySpaceSize<Code>(this->M, D) < N)
+        this->M++;
+    Space* space = new Space();
+    space->D = D;
+    space->N = keySpaceSize<Code>(this->M, D);
+    space->root = Node<T, Code>::create(0, vector<int>(D, 0));
+    this->space = space;
+    this->pointD = D;
+    this->cache = NULL;
+    this->wheel = NULL;
+    this->capacity = 0;
+    this->n_nodes = 0;
+}
+
+/**
+ * MDList destructor.
+ * Frees every Node. No operation may be running.
+ */
+template <class T, class Codec>
+MDList<T, Codec>::~MDList ()
+{
+    destroySubtree<T, Code>(this->space.load()->root);
+    delete this->space.load();
+    LookupCache<T, Code>::destroy(this->cache);
+    delete this->wheel.load();
+}
+
+/**
+ * Locate Predecessor/Parent of given coordinates.
+ * @param space The key space.
+ * @param coordinates The given coordinates.
+ * @returns Pair(predecessor, current) where predecessor is
+ *          parent of current.
+ */
+template <class T, class Codec>
+pair<Node<T, typename Codec::Code>*, Node<T, typename Codec::Code>*>
+MDList<T, Codec>::locatePredecessor (Space* space, vector<int> coordinates)
+{
+    int D = space->D;
+    start_l:
+    Node<T, Code>* current = space->root;
+    Node<T, Code>* predecessor = NULL;
+    int d = 0;
+    while (d < D)
+    {
+        while (current != NULL && coordinates[d] > current->getCoordinate(d, D)){
+            predecessor = current;
+            current = current->getChild(d, D);
+            // The child may have been moved to a Node inserted
+            // above predecessor, so start again. If the key space
+            // has grown meanwhile, the caller starts again instead.
+            if (d < predecessor->getMinDimension(D) &&
+                    space == this->space.load())
+                goto start_l;
+        }
+        // Check if we found the predecessor.
+        if (current == NULL || coordinates[d] < current->getCoordinate(d, D))
+            break;
+        else
+            d++;
+    }
+    return make_pair(predecessor, current);
+}
+
+/**
+ * Insert (key, value) to MDList.
+ * @param key The key.
+ * @param val The value.
+ */
+template <class T, class Codec>
+void MDList<T, Codec>::insert (Key key, T val)
+{
+    this->insertCode(Codec::encode(key), val);
+}
+
+/**
+ * Insert (key, value) to MDList.
+ * @param key The encoded key.
+ * @param val The value.
+ */
+template <class T, class Codec>
+void MDList<T, Codec>::insertCode (Code key, T val)
+{
+    if (!this->fits(key))
+        this->grow(key);
+    {
+        ReclaimGuard guard(this->reclaimer);
+        this->insertNode(key, val, NULL);
+    }
+    this->maintain();
+}
+
+/**
+ * Insert (key, value) to MDList, which expires after given
+ * time to live. Once expired, the key is treated as absent
+ * and is removed by later operations.
+ * @param key The key.
+ * @param val The value.
+ * @param ttl The time to live.
+ */
+template <class T, class Codec>
+void MDList<T, Codec>::insert (Key key, T val, std::chrono::milliseconds ttl)
+{
+    Code code = Codec::encode(key);
+    if (!this->fits(code))
+        this->grow(code);
+    ULL expiry = steadyNanos() + std::chrono::duration_cast<
+                     std::chrono::nanoseconds>(max(ttl, std::chrono::milliseconds(0))).count();
+    ExpiryWheel<Code>* wheel = this->wheel.load();
+    if (wheel == NULL)
+    {
+        ExpiryWheel<Code>* created = new ExpiryWheel<Code>();
+        if (this->wheel.compare_exchange_strong(wheel, created))
+            wheel = created;
+        else
+            delete created;
+    }
+    {
+        ReclaimGuard guard(this->reclaimer);
+        this->insertNode(code, val, NULL, expiry);
+    }
+    wheel->add(code, expiry);
+    this->maintain();
+}
+
+/**
+ * Inserts (key, value), or claims the Node of key for a
+ * multiUpdate. Waits while another multiUpdate owns the key.
+ * The caller must hold a ReclaimGuard and key must be
+ * in the key space.
+ * @param key The key.
+ * @param val The value, ignored if owner is given.
+ * @param owner The multiUpdate to own the Node, or NULL
+ *              for a plain insert.
+ * @param expiry Expiry time of value in steadyNanos, 0 if
+ *               it does not expire.
+ * @returns The Node of key.
+ */
+template <class T, class Codec>
+Node<T, typename Codec::Code>*
+MDList<T, Codec>::insertNode (Code key, T val, UpdateDescriptor<T, Code>* owner,
+                              ULL expiry)
+{
+    start:
+    Space* space = this->space.load();
+    int D = space->D;
+    vector<int> coordinates = keyToDigits(key, D, this->M);
+    pair<Node<T, Code>*, Node<T, Code>*> p = locatePredecessor(space, coordinates);
+    Node<T, Code>* predecessor = p.first;
+    Node<T, Code>* current = p.second;
+    // Lock for thread safety
+    if (predecessor != NULL && !predecessor->try_lock())
+        goto start;
+    if (current != NULL && !current->try_lock())
+    {
+        if (predecessor != NULL)
+            predecessor->unlock();
+        goto start;
+    }
+    // Check predecessor and current are still valid
+    p = locatePredecessor(space, coordinates);
+    if (predecessor != p.first || current != p.second ||
+            space != this->space.load())
+    {
+        if (predecessor != NULL)
+            predecessor->unlock();
+        if (current != NULL)
+            current->unlock();
+        goto start;
+    }
+    // Check if key already exists.
+    if (current != NULL && key == current->getKey())
+    {
+        if (predecessor != NULL)
+            predecessor->unlock();
+        // Wait for the multiUpdate owning it.
+        if (current->getOwner() != NULL)
+        {
+            current->unlock();
+            std::this_thread::yield();
+            goto start;
+        }
+        // Update value and return.
+        if (owner != NULL)
+            current->setOwner(owner);
+        else
+            current->setValue(val, expiry);
+        current->unlock();
+        return current;
+    }
+    // Key doesn't exits, create new Node.
+    // A multiUpdate starts with an absent value.
+    Node<T, Code>* node = Node<T, Code>::create(key, coordinates, predecessor);
+    if (owner == NULL)
+        node->setValue(val, expiry);
+    node->setOwner(owner);
+    if (this->capacity.load() != 0)
+        this->n_nodes++;
+    // Find position of node in predecessor
+    int d = 0;
+    while (d < D && coordinates[d] <= predecessor->getCoordinate(d, D))
+        d++;
+    if (d >= D)
+        throw "Given key is out of key space";
+    int _d = d;
+    // If current is NULL, then node is _dth child of predecessor.
+    if (current == NULL)
+    {
+        predecessor->setChild(_d, D, node, &this->reclaimer);
+        predecessor->unlock();
+        return node;
+    }
+    // Assign appropriate childrens to node.
+    while (d < D)
+    {
+        // Check if current can be dth child of node.
+        if (coordinates[d] < current->getCoordinate(d, D)){
+            node->setChild(d, current);
+            break;
+        }
+        // Else dth child of current is dth child of node
+        node->setChild(d, current->getChild(d, D));
+        d++;
+    }
+    // Assign predecessor as parent to node.
+    predecessor->setChild(_d, D, node, &this->reclaimer);
+    // Traversals which reached current before node was
+    // linked may still follow the moved children, so
+    // they are removed from current only now.
+    current->setMinDimension(d, D);
+    for (int i = _d; i < d; i++)
+        current->setChild(i, D, NULL, &this->reclaimer);
+    predecessor->unlock();
+    current->unlock();
+    return node;
+}
+
+/**
+ * Searches for given key.
+ * @param key The key.
+ * @returns The value if key is present else NULL.
+ */
+template <class T, class Codec>
+T MDList<T, Codec>::find (Key key)
+{
+    return this->findCode(Codec::encode(key));
+}
+
+/**
+ * Searches for given key.
+ * @param key The encoded key.
+ * @returns The value if key is present else NULL.
+ */
+template <class T, class Codec>
+T MDList<T, Codec>::findCode (Code key)
+{
+    this->maintain();
+    ReclaimGuard guard(this->reclaimer);
+    start_f:
+    Space* space = this->space.load();
+    if (!space->contains(key))
+        return NULL;
+    ULL version = 0;
+    if (this->cache != NULL)
+    {
+        Node<T, Code>* node = this->cache->lookup(key, version);
+        if (node != NULL)
+            return node->getValue();
+    }
+    vector<int> coordinates = keyToDigits(key, space->D, this->M);
+    pair<Node<T, Code>*, Node<T, Code>*> p = locatePredecessor(space, coordinates);
+    Node<T, Code>* current = p.second;
+    if (current != NULL && current->getKey() == key)
+    {
+        if (this->cache != NULL)
+            this->cache->fill(key, version, current);
+        return current->getValue();
+    }
+    // The search may have missed Nodes moved after the
+    // key space grew.
+    if (space != this->space.load())
+        goto start_f;
+    return NULL;
+}
+
+/**
+ * Removes the given key.
+ * @param key The key.
+ * @returns The value if key present and removed else NULL.
+ */
+template <class T, class Codec>
+T MDList<T, Codec>::remove (Key key)
+{
+    return this->removeCode(Codec::encode(key));
+}
+
+/**
+ * Removes the given key.
+ * @param key The encoded key.
+ * @returns The value if key present and removed else NULL.
+ */
+template <class T, class Codec>
+T MDList<T, Codec>::removeCode (Code key)
+{
+    this->maintain();
+    ReclaimGuard guard(this->reclaimer);
+    return this->removeNode(key, NULL);
+}
+
+/**
+ * Removes the given key. Waits while a multiUpdate other
+ * than owner owns the key. The caller must hold a
+ * ReclaimGuard.
+ * @param key The key.
+ * @param owner The multiUpdate removing the key, or NULL
+ *              for a plain remove.
+ * @param expiry If not 0, the key is removed only if its
+ *               value still has this expiry time.
+ * @returns The value if key present and removed else NULL.
+ */
+template <class T, class Codec>
+T MDList<T, Codec>::removeNode(Code key, UpdateDescriptor<T, Code>* owner, ULL expiry)
+{
+    start_r:
+    Space* space = this->space.load();
+    int D = space->D;
+    if (!space->contains(key))
+        return NULL;
+    // If given key is root
+    // just remove the value
+    // because root cannot be deleted.
+    if (key == 0) 
+    {
+        space->root->lock();
+        if (space != this->space.load() || space->root->getOwner() != owner)
+        {
+            space->root->unlock();
+            std::this_thread::yield();
+            goto start_r;
+        }
+        if (expiry != 0 && space->root->getExpiry() != expiry)
+        {
+            space->root->unlock();
+            return NULL;
+        }
+        T val = space->root->getValue();
+        space->root->setValue(NULL);
+        space->root->setOwner(NULL);
+        space->root->unlock();
+        return val;
+    }
+    vector<int> coordinates = keyToDigits(key, D, this->M);
+    pair<Node<T, Code>*, Node<T, Code>*> p = locatePredecessor(space, coordinates);
+    Node<T, Code>* predecessor = p.first;
+    Node<T, Code>* current = p.second;
+    // Lock for thread safety
+    if (predecessor != NULL && !predecessor->try_lock())
+        goto start_r;
+    if (current != NULL && !current->try_lock())
+    {
+        if (predecessor != NULL)
+            predecessor->unlock();
+        goto start_r;
+    }
+    // Check predecessor and current are still valid,
+    // before relying on current being child of predecessor.
+    p = locatePredecessor(space, coordinates);
+    if (predecessor != p.first || current != p.second ||
+            space != this->space.load())
+    {
+        if (predecessor != NULL)
+            predecessor->unlock();
+        if (current != NULL)
+            current->unlock();
+        goto start_r;
+    }
+    if (current == NULL || current->getKey() != key)
+    {
+        if (predecessor != NULL)
+            predecessor->unlock();
+        if (current != NULL)
+            current->unlock();
+        return NULL;
+    }
+    // Wait for the multiUpdate owning current.
+    if (current->getOwner() != owner)
+    {
+        if (predecessor != NULL)
+            predecessor->unlock();
+        current->unlock();
+        std::this_thread::yield();
+        goto start_r;
+    }
+    // The value was replaced since it was due to expire.
+    if (expiry != 0 && current->getExpiry() != expiry)
+    {
+        if (predecessor != NULL)
+            predecessor->unlock();
+        current->unlock();
+        return NULL;
+    }
+
+    // Find the index of current in predecessor
+    int d = 0;
+    while (d < D && predecessor->getChild(d, D) != current)
+        d++;
+    if (d >= D)
+        throw "Given key is out of key space";
+    // The last indexed child of current will be the new current
+    Node<T, Code>* new_current = NULL;
+    int _d = D;
+    while (_d > 0 && new_current == NULL) {
+        _d--;
+        new_current = current->getChild(_d, D);
+    }
+    // Try lock for new_current
+    if (new_current != NULL && !new_current->try_lock())
+    {
+        if (predecessor != NULL)
+            predecessor->unlock();
+        if (current != NULL)
+            current->unlock();
+        goto start_r;
+    }
+    // Transer children of current to new current
+    _d--;
+    while (_d >= 0) {
+        new_current->setChild(_d, D, current->getChild(_d, D),
+                              &this->reclaimer);
+        _d--;
+    }
+    // Update predecessor pointer
+    if (new_current != NULL)
+        new_current->setMinDimension(d, D);
+    predecessor->setChild(d, D, new_current, &this->reclaimer);
+    if (predecessor)
+        predecessor->unlock();
+    if (new_current)
+        new_current->unlock();
+    T val = current->getValue();
+    current->unlock();
+    if (this->capacity.load() != 0)
+        this->n_nodes--;
+    if (this->cache != NULL)
+        this->cache->invalidate(key);
+    // Concurrent traversals may still hold current,
+    // so it is freed once they are done.
+    this->reclaimer.retire(current, destroyObject< Node<T, Code> >);
+    return val;
+}
+
+/**
+ * Applies a group of inserts and removes atomically.
+ * Concurrent operations see either none or all of them.
+ * The keys are claimed in ascending order, so groups with
+ * disjoint keys run in parallel and overlapping groups
+ * cannot deadlock. Plain inserts and removes of a claimed
+ * key wait for the group to finish.
+ * @param ops The operations, each on a different key.
+ * @returns The previous value of each key, in the order of ops.
+ */
+template <class T, class Codec>
+vector<T> MDList<T, Codec>::multiUpdate (vector< UpdateOp<T, Key> > ops)
+{
+    size_t n = ops.size();
+    vector<T> previous(n, NULL);
+    if (n == 0)
+        return previous;
+    vector<Code> codes(n);
+    vector<size_t> order(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        codes[i] = Codec::encode(ops[i].key);
+        order[i] = i;
+    }
+    sort(order.begin(), order.end(), [&] (size_t a, size_t b)
+    {
+        return codes[a] < codes[b];
+    });
+    UpdateDescriptor<T, Code>* desc = new UpdateDescriptor<T, Code>();
+    desc->committed = false;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (i > 0 && codes[order[i]] == codes[order[i - 1]])
+        {
+            delete desc;
+            throw "Duplicate key in multiUpdate";
+        }
+        UpdateOp<T, Code> op = {codes[order[i]], ops[order[i]].val,
+                          ops[order[i]].remove};
+        desc->ops.push_back(op);
+    }
+    if (!this->fits(desc->ops[n - 1].key))
+        this->grow(desc->ops[n - 1].key);
+    {
+        ReclaimGuard guard(this->reclaimer);
+        // Claim every key, absent keys get a Node with NULL value.
+        vector<Node<T, Code>*> nodes(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            nodes[i] = this->insertNode(desc->ops[i].key, NULL, desc);
+            previous[order[i]] = nodes[i]->getValue();
+        }
+        // All new values become visible here.
+        desc->committed = true;
+        // Write them to the Nodes and release the Nodes.
+        for (size_t i = 0; i < n; i++)
+        {
+            if (desc->ops[i].remove)
+            {
+                this->removeNode(desc->ops[i].key, desc);
+                continue;
+            }
+            nodes[i]->lock();
+            nodes[i]->setValue(desc->ops[i].val);
+            nodes[i]->setOwner(NULL);
+            nodes[i]->unlock();
+        }
+    }
+    // Readers may still hold desc through a removed Node.
+    this->reclaimer.retire(desc, destroyObject< UpdateDescriptor<T, Code> >);
+    return previous;
+}
+
+/**
+ * Number of workers for a parallel operation.
+ * @param threads The number asked for, 0 for one per core.
+ * @returns The number of workers, at least 1.
+ */
+template <class T, class Codec>
+int MDList<T, Codec>::workers (int threads)
+{
+    if (threads <= 0)
+        threads = thread::hardware_concurrency();
+    return max(threads, 1);
+}
+
+/**
+ * Visits every Node of given subtrees with a pool of
+ * work-stealing workers. The D child subtrees of a Node
+ * are disjoint, so a worker walks its task depth first on
+ * a local stack, and whenever its queue is empty it moves
+ * the oldest entry of the stack, the largest subtree it
+ * has not visited, to the queue for idle workers to steal.
+ * Queues and the count of pending tasks are thus touched
+ * once per task rather than once per Node.
+ * @param starts Roots of the subtrees.
+ * @param states One state per worker. A worker keeps its
+ *               state in a local copy while visiting, so
+ *               workers do not share cache lines, and
+ *               stores it back at the end.
+ * @param fn Called as fn(node, state) for each Node, after
+ *           the children of node are read.
+ * The caller must keep the subtrees alive, usually by
+ * holding a ReclaimGuard.
+ */
+template <class T, class Codec>
+template <class S, class F>
+void MDList<T, Codec>::parallelVisit (vector<Node<T, Code>*> starts, vector<S>& states, F fn)
+{
+    int threads = states.size();
+    vector< WorkStealingQueue<Node<T, Code>*> > queues(threads);
+    // Number of tasks pushed but not yet finished.
+    std::atomic<long> pending(starts.size());
+    for (size_t i = 0; i < starts.size(); i++)
+        queues[i % threads].push(starts[i]);
+    auto worker = [&] (int id)
+    {
+        S state = states[id];
+        vector<Node<T, Code>*> stack;
+        Node<T, Code>* task;
+        int victim = id;
+        while (true)
+        {
+            bool found = queues[id].pop(task);
+            for (int i = 1; !found && i < threads; i++)
+            {
+                victim = (victim + 1) % threads;
+                if (victim != id)
+                    found = queues[victim].steal(task);
+            }
+            if (!found)
+            {
+                if (pending.load() == 0)
+                    break;
+                std::this_thread::yield();
+                continue;
+            }
+            stack.push_back(task);
+            // Entries below bottom were handed to the queue.
+            size_t bottom = 0;
+            while (stack.size() > bottom)
+            {
+                if (threads > 1 && stack.size() - bottom > 1 && queues[id].empty())
+                {
+                    pending.fetch_add(1);
+                    queues[id].push(stack[bottom++]);
+                    continue;
+                }
+                Node<T, Code>* node = stack.back();
+                stack.pop_back();
+                vector<Node<T, Code>*> children = node->getChildren();
+                for (int d = children.size() - 1; d >= 0; d--)
+                    if (children[d] != NULL)
+                        stack.push_back(children[d]);
+                fn(node, state);
+            }
+            stack.clear();
+            pending.fetch_sub(1);
+        }
+        states[id] = state;
+    };
+    vector<thread> pool;
+    for (int i = 1; i < threads; i++)
+        pool.push_back(thread(worker, i));
+    worker(0);
+    for (size_t i = 0; i < pool.size(); i++)
+        pool[i].join();
+}
+
+/**
+ * Calls fn(key, value) for every (key, value) pair in parallel.
+ * Safe to run alongside writers, with weak consistency:
+ * nothing freed is ever visited, and pairs which concurrent
+ * writers do not insert, remove or move are visited exactly
+ * once. Pairs inserted or removed meanwhile, or moved when a
+ * Node above them is inserted or removed, may be missed or
+ * visited twice.
+ * @param fn The function, must be thread safe.
+ * @param threads The number of threads, 0 for one per core.
+ */
+template <class T, class Codec>
+template <class F>
+void MDList<T, Codec>::parallel_for_each (F fn, int threads)
+{
+    vector<char> unused(workers(threads));
+    ReclaimGuard guard(this->reclaimer);
+    this->parallelVisit(vector<Node<T, Code>*>(1, this->space.load()->root), unused,
+                        [&fn] (Node<T, Code>* node, char&)
+    {
+        T val = node->getValue();
+        if (val != NULL)
+            fn(Codec::decode(node->getKey()), val);
+    });
+}
+
+/**
+ * Reduces all (key, value) pairs in parallel.
+ * Each worker folds its pairs into its own accumulator,
+ * and the accumulators are combined at the end.
+ * Consistency is the same as parallel_for_each.
+ * @param identity The identity of combine.
+ * @param map Maps (key, value) to R.
+ * @param combine Combines two R, must be associative
+ *                and commutative.
+ * @param threads The number of threads, 0 for one per core.
+ * @returns The reduced value.
+ */
+template <class T, class Codec>
+template <class R, class Map, class Combine>
+R MDList<T, Codec>::parallel_reduce (R identity, Map map, Combine combine,
+                                     int threads)
+{
+    vector<R> partial(workers(threads), identity);
+    ReclaimGuard guard(this->reclaimer);
+    this->parallelVisit(vector<Node<T, Code>*>(1, this->space.load()->root), partial,
+                        [&map, &combine] (Node<T, Code>* node, R& acc)
+    {
+        T val = node->getValue();
+        if (val != NULL)
+            acc = combine(acc, map(Codec::decode(node->getKey()), val));
+    });
+    R result = identity;
+    for (size_t i = 0; i < partial.size(); i++)
+        result = combine(result, partial[i]);
+    return result;
+}
+
+/**
+ * Removes all (key, value) pairs.
+ * The children of root are detached at once, and once no
+ * traversal can reach them anymore, they are freed in
+ * parallel. Must not be called from inside a traversal
+ * of this MDList, e.g. from parallel_for_each.
+ * Not atomic with concurrent writes: an insert which already
+ * went below root when it was detached is lost, and a
+ * multiUpdate in progress is not waited for.
+ * @param threads The number of threads, 0 for one per core.
+ */
+template <class T, class Codec>
+void MDList<T, Codec>::clear (int threads)
+{
+    vector<Node<T, Code>*> detached;
+    {
+        // A concurrent grow may retire the Space and root.
+        ReclaimGuard guard(this->reclaimer);
+        Space* space;
+        do
+        {
+            space = this->space.load();
+            space->root->lock();
+            if (space == this->space.load())
+                break;
+            space->root->unlock();
+        } while (true);
+        Node<T, Code>* root = space->root;
+        for (int d = 0; d < space->D; d++)
+        {
+            Node<T, Code>* child = root->getChild(d);
+            if (child != NULL)
+                detached.push_back(child);
+            root->setChild(d, NULL, &this->reclaimer);
+        }
+        root->setValue(NULL);
+        root->unlock();
+    }
+    if (detached.empty())
+        return;
+    if (this->cache != NULL)
+        this->cache->invalidateAll();
+    // Wait for operations which may still be inside
+    // the detached subtrees.
+    this->reclaimer.synchronize();
+    vector<long> deleted(workers(threads), 0);
+    this->parallelVisit(detached, deleted, [] (Node<T, Code>* node, long& count)
+    {
+        delete node;
+        count++;
+    });
+    if (this->capacity.load() != 0)
+        for (size_t i = 0; i < deleted.size(); i++)
+            this->n_nodes -= deleted[i];
+}
+
+/**
+ * Removes all keys in range [lo, hi].
+ * Subtrees which lie entirely in the range are detached
+ * from their parent at once and freed together. Only the
+ * Nodes on the boundary of the range are removed one by one.
+ * As with clear, a concurrent insert which already went
+ * into a detached subtree is lost, and a multiUpdate in
+ * progress is not waited for.
+ * @param lo_key The lowest key to remove.
+ * @param hi_key The highest key to remove.
+ */
+template <class T, class Codec>
+void MDList<T, Codec>::eraseRange (Key lo_key, Key hi_key)
+{
+    Code lo = Codec::encode(lo_key), hi = Codec::encode(hi_key);
+    vector<Code> boundary;
+    vector<Node<T, Code>*> detached;
+    {
+        ReclaimGuard guard(this->reclaimer);
+        Space* space = this->space.load();
+        int D = space->D;
+        if (lo > hi || !space->contains(lo))
+            return;
+        // Stack of (node, dimension it was reached by).
+        vector< pair<Node<T, Code>*, int> > stack;
+        stack.push_back(make_pair(space->root, 0));
+        while (stack.size() > 0)
+        {
+            Node<T, Code>* node = stack.back().first;
+            int dim = stack.back().second;
+            stack.pop_back();
+            if (node->getKey() >= lo && node->getKey() <= hi)
+                boundary.push_back(node->getKey());
+            vector<int> coordinates = node->getCoordinates(D);
+            for (int d = dim; d < D; d++)
+            {
+                Node<T, Code>* child = node->getChild(d, D);
+                if (child == NULL)
+                    continue;
+                // Keys below child are in [child key, last].
+                Code first = child->getKey();
+                Code last = prefixMaxKey<Code>(coordinates, d, D, this->M);
+                if (first > hi || last < lo)
+                    continue;
+                if (first < lo || last > hi)
+                {
+                    stack.push_back(make_pair(child, d));
+                    continue;
+                }
+                // Whole subtree is in range, detach it
+                // if node is still in the MDList.
+                node->lock();
+                pair<Node<T, Code>*, Node<T, Code>*> p = locatePredecessor(space, coordinates);
+                if (p.second == node && node->getChild(d, D) == child &&
+                        space == this->space.load())
+                {
+                    node->setChild(d, D, NULL, &this->reclaimer);
+                    node->unlock();
+                    detached.push_back(child);
+                }
+                else
+                {
+                    node->unlock();
+                    stack.push_back(make_pair(child, d));
+                }
+            }
+        }
+        if (this->capacity.load() != 0 && detached.size() > 0)
+            this->n_nodes -= this->countNodes(detached);
+    }
+    if (this->cache != NULL && detached.size() > 0)
+        this->cache->invalidateAll();
+    for (size_t i = 0; i < detached.size(); i++)
+        this->reclaimer.retire(detached[i], destroySubtree<T, Code>);
+    for (size_t i = 0; i < boundary.size(); i++)
+        this->removeCode(boundary[i]);
+}
+
 /**
- * Node Class Constructor.
- * @param key The key.
- * @param D D value of MDList.
- * @param N The key space.
- * @param val The value (optional).
+ * Enables the hot key cache.
+ * Must be called before the MDList is shared between threads.
+ * @param size Number of cache slots.
  */
-template <class T>
-Node<T>::Node (ULL key, int D, ULL N, T val) 
+template <class T, class Codec>
+void MDList<T, Codec>::enableCache (size_t size)
 {
-    this->key = key;
-    this->val = val;
-    this->COORDINATES = keyToCoordinates(key, D, N);
-    this->child.assign(D, NULL);
+    LookupCache<T, Code>::destroy(this->cache);
+    this->cache = LookupCache<T, Code>::create(size);
 }
 
 /**
- * Locks the node mutex.
+ * Removes up to EXPIRY_BATCH expired keys whose turn in the
+ * timer wheel has come. Insert, find and remove call this,
+ * so it is only needed to release memory of an idle MDList.
  */
-template <class T>
-void Node<T>::lock () 
+template <class T, class Codec>
+void MDList<T, Codec>::expire ()
 {
-    this->mutex.lock();
+    ExpiryWheel<Code>* wheel = this->wheel.load();
+    if (wheel == NULL)
+        return;
+    ULL now = steadyNanos();
+    if (!wheel->due(now))
+        return;
+    vector< pair<Code, ULL> > expired;
+    wheel->collect(now, expired, EXPIRY_BATCH);
+    ReclaimGuard guard(this->reclaimer);
+    for (size_t i = 0; i < expired.size(); i++)
+        this->removeNode(expired[i].first, NULL, expired[i].second);
 }
 
 /**
- * Non blocking lock operation on node mutex.
- * @returns True if locked else False.
+ * Upkeep done by every insert, find and remove: removes
+ * some expired keys, and evicts keys while over capacity.
  */
-template <class T>
-bool Node<T>::try_lock ()
+template <class T, class Codec>
+void MDList<T, Codec>::maintain ()
 {
-    return this->mutex.try_lock();
+    this->expire();
+    ULL capacity = this->capacity.load();
+    // Two per call, so eviction keeps up with inserts.
+    for (int i = 0; i < 2 && capacity != 0 &&
+            this->n_nodes.load() > (long) capacity; i++)
+        this->evict();
 }
 
 /**
- * Unlocks the node mutex.
+ * Walks from root to a leaf, going to a random child at
+ * each Node. The caller must hold a ReclaimGuard.
+ * @param space The key space.
+ * @param sampled Gets the Nodes on the walk, except root.
  */
-template <class T>
-void Node<T>::unlock ()
+template <class T, class Codec>
+void MDList<T, Codec>::sampleNodes (Space* space, vector<Node<T, Code>*>& sampled)
 {
-    this->mutex.unlock();
+    Node<T, Code>* node = space->root;
+    while (true)
+    {
+        vector<Node<T, Code>*> children = node->getChildren();
+        vector<Node<T, Code>*> present;
+        for (size_t d = 0; d < children.size(); d++)
+            if (children[d] != NULL)
+                present.push_back(children[d]);
+        if (present.empty())
+            return;
+        node = present[randomULL() % present.size()];
+        sampled.push_back(node);
+    }
 }
 
 /**
- * Getter for key
- * @returns The key of Node.
+ * Removes a key picked from the Nodes on EVICTION_SAMPLES
+ * random walks, the one which expires first, keys without
+ * expiry last.
+ * @returns False if there was no key to remove.
  */
-template <class T>
-ULL Node<T>::getKey ()
+template <class T, class Codec>
+bool MDList<T, Codec>::evict ()
 {
-    // Constant so no need for lock
-    return this->key;
+    ReclaimGuard guard(this->reclaimer);
+    Space* space = this->space.load();
+    vector<Node<T, Code>*> sampled;
+    for (int i = 0; i < EVICTION_SAMPLES; i++)
+        this->sampleNodes(space, sampled);
+    if (sampled.empty())
+        return false;
+    // Nodes near root are on most walks, so
+    // among keys without expiry take the deepest.
+    Node<T, Code>* victim = sampled.back();
+    ULL victim_expiry = victim->getExpiry();
+    for (size_t i = 0; i < sampled.size(); i++)
+    {
+        ULL expiry = sampled[i]->getExpiry();
+        if (expiry != 0 && (victim_expiry == 0 || expiry < victim_expiry))
+        {
+            victim = sampled[i];
+            victim_expiry = expiry;
+        }
+    }
+    this->removeNode(victim->getKey(), NULL);
+    return true;
 }
 
 /**
- * Setter for value.
- * @param val The value.
+ * Counts the Nodes of given subtrees.
+ * The caller must hold a ReclaimGuard.
+ * @param starts Roots of the subtrees.
+ * @returns The number of Nodes.
  */
-template <class T>
-void Node<T>::setValue (T val)
+template <class T, class Codec>
+long MDList<T, Codec>::countNodes (vector<Node<T, Code>*> starts)
 {
-    this->val_mutex.lock();
-    this->val = val;
-    this->val_mutex.unlock();
+    vector<long> count(1, 0);
+    this->parallelVisit(starts, count, [] (Node<T, Code>*, long& n)
+    {
+        n++;
+    });
+    return count[0];
 }
 
 /**
- * Getter for Value.
- * @returns The value.
+ * Limits the number of keys. Inserting past the limit evicts
+ * keys picked by sampling, preferring those which expire first.
+ * @param entries The limit, 0 for no limit.
  */
-template <class T>
-T Node<T>::getValue ()
+template <class T, class Codec>
+void MDList<T, Codec>::setCapacity (ULL entries)
 {
-    this->val_mutex.lock();
-    T t = this->val;
-    this->val_mutex.unlock();
-    return t;
+    if (entries != 0 && this->capacity.load() == 0)
+    {
+        ReclaimGuard guard(this->reclaimer);
+        vector<Node<T, Code>*> root(1, this->space.load()->root);
+        this->n_nodes = this->countNodes(root) - 1;
+    }
+    this->capacity = entries;
+    while (entries != 0 && this->n_nodes.load() > (long) entries &&
+            this->evict())
+        ;
 }
 
 /**
- * Setter for child Node.
- * @param index The index of Child.
- * @param childNode The child Node.
+ * Limits the memory used by Nodes, approximately. The budget
+ * is turned into a capacity using the estimated size of a Node.
+ * @param bytes The budget, 0 for no limit.
  */
-template <class T>
-void Node<T>::setChild (int index, Node* childNode)
+template <class T, class Codec>
+void MDList<T, Codec>::setByteBudget (ULL bytes)
 {
-    if (index < 0 && index >= this->child.size())
-        throw "Index out of bounds";
-    this->child_mutex.lock();
-    this->child[index] = childNode;
-    this->child_mutex.unlock();
+    int D = this->getD();
+#ifdef MDLIST_COMPACT_NODES
+    // Assumes two children per Node on average.
+    ULL node = sizeof(Node<T, Code>) + D * sizeof(int) + sizeof(ULL) +
+               2 * sizeof(Node<T, Code>*);
+#elif defined(MDLIST_ALIGNED_NODES)
+    ULL node = (Node<T, Code>::allocationSize(D) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+#else
+    ULL node = sizeof(Node<T, Code>) + D * (sizeof(int) + sizeof(Node<T, Code>*));
+#endif
+    this->setCapacity(bytes == 0 ? 0 : max(bytes / node, 1ULL));
 }
 
 /**
- * Getter for Child.
- * @param index The index of child.
- * @returns The child.
+ * Getter for number of cache hits.
+ * @returns The number of hits, 0 if cache is disabled.
  */
-template <class T>
-Node<T>* Node<T>::getChild (int index)
+template <class T, class Codec>
+ULL MDList<T, Codec>::cacheHits ()
 {
-    if (index < 0 && index >= this->child.size())
-        throw "Index out of bounds";
-    this->child_mutex.lock();
-    Node<T>* node = this->child[index];
-    this->child_mutex.unlock();
-    return node;
+    return this->cache == NULL ? 0 : this->cache->hits();
 }
 
 /**
- * Getter for Node coordinates.
- * @returns The Node coordinates.
+ * Getter for number of cache misses.
+ * @returns The number of misses, 0 if cache is disabled.
  */
-template <class T>
-vector<int> Node<T>::getCoordinates ()
+template <class T, class Codec>
+ULL MDList<T, Codec>::cacheMisses ()
 {
-    return this->COORDINATES;
+    return this->cache == NULL ? 0 : this->cache->misses();
 }
 
+/**
+ * Getter for D value.
+ * @returns Number of dimensions of the current key space.
+ */
+template <class T, class Codec>
+int MDList<T, Codec>::getD ()
+{
+    ReclaimGuard guard(this->reclaimer);
+    return this->space.load()->D;
+}
 
 /**
- * MDList class
- * MDList is a dictionary based datastruture which stores 
- * (key, value) pairs. It has a root node. Opoerations performed
- * on a MDList are insert, find, remove.
- * MDList is Lock-Free datastructure, so it is thread safe.
+ * Getter for key space.
+ * @returns Size of the current key space, 0 if it holds every Code.
  */
-template <class T>
-class MDList
+template <class T, class Codec>
+typename Codec::Code MDList<T, Codec>::getN ()
 {
-    /**
-     * The D value of MDList.
-     */
-    int                         D;
-    /**
-     * The key space.
-     */
-    ULL                         N;
-    /**
-     * Head or Root of the MDList.
-     */
-    Node<T>*                    root;
-    pair<Node<T>*, Node<T>*>    locatePredecessor(vector<int>);
-    public:
-                                MDList(int, ULL);
-    void                        insert(ULL, T);
-    T                           find(ULL);
-    T                           remove(ULL);
-    template <class _T>
-    friend void                 printMDList(MDList<_T>);
-    template <class _T>
-    friend void                 findAndPrint(MDList<_T>, ULL);
-};
+    ReclaimGuard guard(this->reclaimer);
+    return this->space.load()->N;
+}
 
 /**
- * MDList constructor.
- * @param D The D value of MDList.
- * @param N The key space.
+ * Checks if key is in the current key space. A concurrent
+ * grow may retire the Space, so it is read under a guard.
+ * @param key The key.
+ * @returns True if key is in the key space.
  */
-template <class T>
-MDList<T>::MDList (int D, ULL N)
+template <class T, class Codec>
+bool MDList<T, Codec>::fits (Code key)
 {
-    this->D = D;
-    this->N = N;
-    this->root = new Node<T>(0, D, N);
+    ReclaimGuard guard(this->reclaimer);
+    return this->space.load()->contains(key);
 }
 
 /**
- * Locate Predecessor/Parent of given coordinates.
- * @param coordinates The given coordinates.
- * @returns Pair(predecessor, current) where predecessor is
- *          parent of current.
+ * Grows the key space until it contains the given key.
+ * Each step adds a leading dimension: existing Nodes keep their
+ * coordinates with a leading 0, so only the root is replaced by
+ * one with a child slot for the new dimension. The old root is
+ * locked while being copied, and operations which locked it
+ * before fail their validation and retry in the new key space.
+ * @param key The key.
  */
-template <class T>
-pair<Node<T>*, Node<T>*> MDList<T>::locatePredecessor (vector<int> coordinates)
+template <class T, class Codec>
+void MDList<T, Codec>::grow (Code key)
 {
-    Node<T>* current = this->root;
-    Node<T>* predecessor = NULL;
-    int d = 0;
-    while (d < this->D)
+    this->grow_mutex.lock();
+    Space* space = this->space.load();
+    while (!space->contains(key))
     {
-        while (current != NULL && coordinates[d] > current->getCoordinates()[d]){
-            predecessor = current;
-            current = current->getChild(d);
+        Node<T, Code>* grown_root;
+        try
+        {
+            // Throws if compact Nodes run out of dimensions.
+            grown_root = Node<T, Code>::create(0, vector<int>(space->D + 1, 0));
         }
-        // Check if we found the predecessor.
-        if (current == NULL || coordinates[d] < current->getCoordinates()[d])
-            break;
-        else
-            d++;
+        catch (...)
+        {
+            this->grow_mutex.unlock();
+            throw;
+        }
+        Space* grown = new Space();
+        grown->D = space->D + 1;
+        grown->N = space->N > maxCode<Code>() / this->M ? 0 : space->N * this->M;
+        grown->root = grown_root;
+        Node<T, Code>* root = space->root;
+        root->lock();
+        // Wait for a multiUpdate owning the root.
+        while (root->getOwner() != NULL)
+        {
+            root->unlock();
+            std::this_thread::yield();
+            root->lock();
+        }
+        grown->root->setValue(root->getValue(), root->getExpiry());
+        for (int d = 0; d < space->D; d++)
+            grown->root->setChild(d + 1, root->getChild(d));
+        this->space.store(grown);
+        root->unlock();
+        if (this->cache != NULL)
+            this->cache->invalidate(0);
+        this->reclaimer.retire(root, destroyObject< Node<T, Code> >);
+        this->reclaimer.retire(space, destroyObject<Space>);
+        space = grown;
     }
-    return make_pair(predecessor, current);
+    this->grow_mutex.unlock();
 }
 
 /**
- * Insert (key, value) to MDList.
- * @param key The key.
+ * Converts a point to its key.
+ * @param point The point, one coordinate per dimension the
+ *              MDList was built with, each in [0, M).
+ * @returns The key.
+ */
+template <class T, class Codec>
+typename Codec::Code MDList<T, Codec>::pointToKey (const vector<int>& point)
+{
+    if ((int) point.size() != this->pointD)
+        throw "Point has wrong number of dimensions";
+    Code key;
+    for (int d = 0; d < this->pointD; d++)
+        if (point[d] < 0 || point[d] >= (int) this->M)
+            throw "Point is out of key space";
+    if (!digitsToKey(point, this->pointD, this->M, key))
+        throw "Point is out of key space";
+    return key;
+}
+
+/**
+ * Insert (point, value) to MDList.
+ * @param point The point.
  * @param val The value.
  */
-template <class T>
-void MDList<T>::insert (ULL key, T val)
+template <class T, class Codec>
+void MDList<T, Codec>::insertPoint (const vector<int>& point, T val)
 {
-    if (key < 0 || key >= N)
-        return;
-    start:
-    vector<int> coordinates = keyToCoordinates(key, this->D, this->N);
-    pair<Node<T>*, Node<T>*> p = locatePredecessor(coordinates);
-    Node<T>* predecessor = p.first;
-    Node<T>* current = p.second;
-    // Lock for thread safety
-    if (predecessor != NULL && !predecessor->try_lock())
-        goto start;
-    if (current != NULL && !current->try_lock())
-    {
-        if (predecessor != NULL)
-            predecessor->unlock();
-        goto start;
-    }
-    // Check predecessor and current are still valid
-    p = locatePredecessor(coordinates);
-    if (predecessor != p.first || current != p.second)
-    {
-        if (predecessor != NULL)
-            predecessor->unlock();
-        if (current != NULL)
-            current->unlock();
-        goto start;
-    }
-    // Check if key already exists.
-    if (current != NULL && key == current->getKey())
-    {
-        // Update value and return.
-        current->setValue(val);
-        if (predecessor != NULL)
-            predecessor->unlock();
-        current->unlock();
-        return;
-    }
-    // Key doesn't exits, create new Node.
-    Node<T>* node = new Node<T>(key, this->D, this->N, val);
-    // Find position of node in predecessor
-    int d = 0;
-    while (d < this->D && coordinates[d] <= predecessor->getCoordinates()[d])
-        d++;
-    if (d >= this->D)
-        throw "Given key is out of key space";
-    int _d = d;
-    // If current is NULL, then node is _dth child of predecessor.
-    if (current == NULL)
-    {
-        predecessor->setChild(_d, node);
-        predecessor->unlock();
-        return;
-    }
-    // Assign appropriate childrens to node.
-    while (d < this->D)
-    {
-        // Check if current can be dth child of node.
-        if (node->getCoordinates()[d] < current->getCoordinates()[d]){
-            node->setChild(d, current);
-            break;
-        }
-        // Else dth child of current is dth child of node
-        node->setChild(d, current->getChild(d));
-        current->setChild(d, NULL);
-        d++;
-    }
-    // Assign predecessor as parent to node.
-    predecessor->setChild(_d, node);
-    predecessor->unlock();
-    current->unlock();
+    this->insertCode(this->pointToKey(point), val);
 }
 
 /**
- * Searches for given key.
- * @param key The key.
- * @returns The value if key is present else NULL.
+ * Searches for given point.
+ * @param point The point.
+ * @returns The value if point is present else NULL.
  */
-template <class T>
-T MDList<T>::find (ULL key) 
+template <class T, class Codec>
+T MDList<T, Codec>::findPoint (const vector<int>& point)
 {
-    if (key < 0 || key >= N)
-        return NULL;
-    vector<int> coordinates = keyToCoordinates(key, this->D, this->N);    
-    pair<Node<T>*, Node<T>*> p = locatePredecessor(coordinates);
-    Node<T>* current = p.second;
-    if (current != NULL && current->getKey() == key)
-        return current->getValue();
-    return NULL;
+    return this->findCode(this->pointToKey(point));
 }
 
 /**
- * Removes the given key.
- * @param key The key.
- * @returns The value if key present and removed else NULL.
+ * Removes the given point.
+ * @param point The point.
+ * @returns The value if point present and removed else NULL.
  */
-template <class T>
-T MDList<T>::remove(ULL key)
+template <class T, class Codec>
+T MDList<T, Codec>::removePoint (const vector<int>& point)
 {
-    if (key < 0 || key >= N)
-        return NULL;
-    // If given key is root
-    // just remove the value
-    // because root cannot be deleted.
-    if (key == 0) 
-    {
-        T val = root->getValue();
-        this->root->setValue(NULL);
-        return val;
-    }
-    start_r:
-    vector<int> coordinates = keyToCoordinates(key, this->D, this->N);    
-    pair<Node<T>*, Node<T>*> p = locatePredecessor(coordinates);
-    Node<T>* predecessor = p.first;
-    Node<T>* current = p.second;
-    // Lock for thread safety
-    if (predecessor != NULL && !predecessor->try_lock())
-        goto start_r;
-    if (current != NULL && !current->try_lock())
-    {
-        if (predecessor != NULL)
-            predecessor->unlock();
-        goto start_r;
-    }
-    if (current == NULL || current->getKey() != key)
+    return this->removeCode(this->pointToKey(point));
+}
+
+/**
+ * Finds all points inside a box.
+ * A child reached by dimension d shares the first d coordinates
+ * of its parent and only grows in dimension d, so its subtree
+ * is skipped when those coordinates fall outside the box.
+ * Dimensions added by growth lead the coordinates, and are 0
+ * for every point, so only children by the trailing dimensions
+ * of root are searched.
+ * @param point_lo The lowest coordinate of box in each dimension.
+ * @param point_hi The highest coordinate of box in each dimension.
+ * @returns The (point, value) pairs inside the box.
+ */
+template <class T, class Codec>
+vector< pair<vector<int>, T> > MDList<T, Codec>::rangeQuery (const vector<int>& point_lo,
+                                                             const vector<int>& point_hi)
+{
+    if ((int) point_lo.size() != this->pointD || (int) point_hi.size() != this->pointD)
+        throw "Box has wrong number of dimensions";
+    ReclaimGuard guard(this->reclaimer);
+    Space* space = this->space.load();
+    int D = space->D;
+    int lead = D - this->pointD;
+    vector<int> lo(lead, 0), hi(lead, 0);
+    lo.insert(lo.end(), point_lo.begin(), point_lo.end());
+    hi.insert(hi.end(), point_hi.begin(), point_hi.end());
+    vector< pair<vector<int>, T> > result;
+    // Stack of (node, dimension it was reached by).
+    vector< pair<Node<T, Code>*, int> > stack;
+    stack.push_back(make_pair(space->root, lead));
+    while (stack.size() > 0)
     {
-        print.lock();
-        // cout<<key<<" = "<<current->getKey()<<endl;
-        print.unlock();
-        // printMDList(*this);
-        return NULL;
+        Node<T, Code>* node = stack.back().first;
+        int dim = stack.back().second;
+        stack.pop_back();
+        vector<int> coordinates = node->getCoordinates(D);
+        // Coordinates before dim are equal in the whole subtree.
+        int d = 0;
+        while (d < D && coordinates[d] >= lo[d] && coordinates[d] <= hi[d])
+            d++;
+        if (d == D)
+        {
+            T val = node->getValue();
+            if (val != NULL)
+                result.push_back(make_pair(vector<int>(coordinates.begin() + lead,
+                                                       coordinates.end()), val));
+        }
+        // Children by dimension > d differ from box in dimension d.
+        for (int c = dim; c < D && c <= d; c++)
+        {
+            Node<T, Code>* child = node->getChild(c, D);
+            // Child only grows in dimension c.
+            if (child != NULL && child->getCoordinate(c, D) <= hi[c])
+                stack.push_back(make_pair(child, c));
+        }
     }
+    return result;
+}
 
-    // Find the index of current in predecessor
-    int d = 0;
-    while (d < this->D && predecessor->getChild(d) != current)
-        d++;
-    if (d >= this->D)
-        throw "Given key is out of key space";
-    // The last indexed child of current will be the new current
-    Node<T>* new_current = NULL;
-    int _d = this->D;
-    while (_d > 0 && new_current == NULL) {
-        _d--;
-        new_current = current->getChild(_d);
-    }
-    // Try lock for new_current
-    if (new_current != NULL && !new_current->try_lock())
+/**
+ * Finds the k points nearest to given point by euclidean distance.
+ * Subtrees are searched best first by the lowest distance any
+ * point in them can have, and skipped once k closer points
+ * have been found. As in rangeQuery, only children by the
+ * trailing dimensions of root hold points.
+ * @param original The point.
+ * @param k Number of points to find.
+ * @returns Up to k (point, value) pairs, nearest first.
+ */
+template <class T, class Codec>
+vector< pair<vector<int>, T> > MDList<T, Codec>::nearest (const vector<int>& original,
+                                                          int k)
+{
+    if ((int) original.size() != this->pointD)
+        throw "Point has wrong number of dimensions";
+    ReclaimGuard guard(this->reclaimer);
+    Space* space = this->space.load();
+    int D = space->D;
+    int lead = D - this->pointD;
+    vector<int> point(lead, 0);
+    point.insert(point.end(), original.begin(), original.end());
+    typedef pair<long long, pair<Node<T, Code>*, int> > Entry;
+    typedef pair<long long, pair<vector<int>, T> > Found;
+    // Min heap of subtrees by lowest possible distance.
+    priority_queue<Entry, vector<Entry>, greater<Entry> > subtrees;
+    // Max heap of best points found by distance.
+    auto farther = [] (const Found& a, const Found& b)
     {
-        if (predecessor != NULL)
-            predecessor->unlock();
-        if (current != NULL)
-            current->unlock();
-        goto start_r;
-    }
-    // Check predecessor and current are still valid
-    p = locatePredecessor(coordinates);
-    if (predecessor != p.first || current != p.second || 
-            (current != NULL && current->getKey() != key))
+        return a.first < b.first;
+    };
+    priority_queue<Found, vector<Found>, decltype(farther)> best(farther);
+    subtrees.push(make_pair(0LL, make_pair(space->root, lead)));
+    while (k > 0 && !subtrees.empty())
     {
-        if (predecessor != NULL)
-            predecessor->unlock();
-        if (current != NULL)
-            current->unlock();
-        if (new_current != NULL)
-            new_current->unlock();
-        goto start_r;
+        long long bound = subtrees.top().first;
+        Node<T, Code>* node = subtrees.top().second.first;
+        int dim = subtrees.top().second.second;
+        subtrees.pop();
+        if ((int) best.size() == k && bound >= best.top().first)
+            break;
+        vector<int> coordinates = node->getCoordinates(D);
+        // prefix[d] is the distance over the first d dimensions.
+        vector<long long> prefix(D + 1, 0);
+        for (int d = 0; d < D; d++)
+        {
+            long long diff = coordinates[d] - point[d];
+            prefix[d+1] = prefix[d] + diff * diff;
+        }
+        T val = node->getValue();
+        if (val != NULL)
+        {
+            best.push(make_pair(prefix[D],
+                                make_pair(vector<int>(coordinates.begin() + lead,
+                                                      coordinates.end()), val)));
+            if ((int) best.size() > k)
+                best.pop();
+        }
+        for (int c = dim; c < D; c++)
+        {
+            Node<T, Code>* child = node->getChild(c, D);
+            if (child == NULL)
+                continue;
+            // Child shares first c coordinates and
+            // only grows in dimension c.
+            long long diff = child->getCoordinate(c, D) - point[c];
+            long long lower = prefix[c] + (diff > 0 ? diff * diff : 0);
+            if ((int) best.size() < k || lower < best.top().first)
+                subtrees.push(make_pair(lower, make_pair(child, c)));
+        }
     }
-    // Transer children of current to new current
-    _d--;
-    while (_d >= 0) {
-        new_current->setChild(_d, current->getChild(_d));
-        _d--;
+    vector< pair<vector<int>, T> > result;
+    while (!best.empty())
+    {
+        result.push_back(best.top().second);
+        best.pop();
     }
-    // Update predecessor pointer
-    predecessor->setChild(d, new_current);
-    if (predecessor)
-        predecessor->unlock();
-    if (new_current)
-        new_current->unlock();
-    T val = current->getValue();
-    delete current;
-    return val;
+    reverse(result.begin(), result.end());
+    return result;
 }
 
-
 /**
  * Prints MDList.
  * Only for debug purposes.
  * @param mdList The MDList to print
  */
-template <class T>
-void printMDList (MDList<T> mdList)
+template <class T, class Codec>
+void printMDList (MDList<T, Codec>& mdList)
 {
-    vector< Node<T>* > stack;
-    stack.push_back(mdList.root);
+    typedef typename Codec::Code Code;
+    ReclaimGuard guard(mdList.reclaimer);
+    typename MDList<T, Codec>::Space* space = mdList.space.load();
+    int D = space->D;
+    vector< Node<T, Code>* > stack;
+    stack.push_back(space->root);
     while(stack.size() > 0)
     {
-        Node<T>* node = stack.back();
+        Node<T, Code>* node = stack.back();
         stack.pop_back();
         cout<<node->getKey()<<" ";
-        vector<int> coordinates = node->getCoordinates();
+        vector<int> coordinates = node->getCoordinates(D);
         cout<<"[";
-        for (int d = 0; d < mdList.D; d++)
+        for (int d = 0; d < D; d++)
         {
             cout<<coordinates[d]<<", ";
         }
@@ -526,18 +3797,18 @@ void printMDList (MDList<T> mdList)
             cout<<node->getValue()<<"\n\t";
         else
             cout<<"NULL\n\t";
-        for (int d = 0; d < mdList.D; d++)
+        for (int d = 0; d < D; d++)
         {
-            Node<T>* child = node->getChild(d);
+            Node<T, Code>* child = node->getChild(d, D);
             cout<<d<<" : ";
             if (child == NULL)
                 cout<<"NULL , ";
             else 
             {
                 stack.push_back(child);
-                vector<int> coordinates = child->getCoordinates();
+                vector<int> coordinates = child->getCoordinates(D);
                 cout<<"[";
-                for (int d = 0; d < mdList.D; d++)
+                for (int d = 0; d < D; d++)
                 {
                     cout<<coordinates[d]<<", ";
                 }
@@ -554,18 +3825,28 @@ void printMDList (MDList<T> mdList)
  * @param mdlist The mdlist.
  * @param key The key.
  */
-template <class T>
-void findAndPrint (MDList<T> mdlist, ULL key) 
+template <class T, class Codec>
+void findAndPrint (MDList<T, Codec>& mdlist, typename Codec::Key original)
 {
-    vector<int> coordinates = keyToCoordinates(key, mdlist.D, mdlist.N);    
-    pair<Node<T>*, Node<T>*> p = mdlist.locatePredecessor(coordinates);
-    Node<T>* node = p.second;
-    if (node->getKey() == key)
+    typedef typename Codec::Code Code;
+    ReclaimGuard guard(mdlist.reclaimer);
+    typename MDList<T, Codec>::Space* space = mdlist.space.load();
+    int D = space->D;
+    Code key = Codec::encode(original);
+    if (!space->contains(key))
+    {
+        cout << key << " Not found!\n";
+        return;
+    }
+    vector<int> coordinates = keyToDigits(key, D, mdlist.M);
+    pair<Node<T, Code>*, Node<T, Code>*> p = mdlist.locatePredecessor(space, coordinates);
+    Node<T, Code>* node = p.second;
+    if (node != NULL && node->getKey() == key)
     {
         cout<<node->getKey()<<" ";
-        vector<int> coordinates = node->getCoordinates();
+        vector<int> coordinates = node->getCoordinates(D);
         cout<<"[";
-        for (int d = 0; d < mdlist.D; d++)
+        for (int d = 0; d < D; d++)
         {
             cout<<coordinates[d]<<", ";
         }
@@ -574,17 +3855,17 @@ void findAndPrint (MDList<T> mdlist, ULL key)
             cout<<node->getValue()<<"\n\t";
         else
             cout<<"NULL\n\t";
-        for (int d = 0; d < mdlist.D; d++)
+        for (int d = 0; d < D; d++)
         {
-            Node<T>* child = node->getChild(d);
+            Node<T, Code>* child = node->getChild(d, D);
             cout<<d<<" : ";
             if (child == NULL)
                 cout<<"NULL , ";
             else 
             {
-                vector<int> coordinates = child->getCoordinates();
+                vector<int> coordinates = child->getCoordinates(D);
                 cout<<"[";
-                for (int d = 0; d < mdlist.D; d++)
+                for (int d = 0; d < D; d++)
                 {
                     cout<<coordinates[d]<<", ";
                 }
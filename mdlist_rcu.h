@@ -0,0 +1,903 @@
+/**
+ * @file mdlist_rcu.h
+ * @brief Read-mostly MDList, whose writers publish new
+ * versions copy on write.
+ *
+ * Nodes of a published version are never changed. A writer
+ * copies the Nodes it changes, and the Nodes on the path from
+ * root to them, and publishes the result by swapping the
+ * version pointer. Readers load the version once and traverse
+ * plain memory, without locks. Replaced Nodes are freed once
+ * every reader thread has passed through a quiescent state.
+ */
+
+#ifndef _mdlist_rcu_h_
+#define _mdlist_rcu_h_
+
+#include <unordered_set>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/membarrier.h>
+#endif
+#include "mdlist.h"
+
+/**
+ * RCUNode class.
+ * Node of an RCUMDList. The D children, and then the D
+ * coordinates, follow the Node in the same allocation.
+ * Once published a Node is never changed.
+ */
+template <class T, class K = ULL>
+class RCUNode
+{
+                    RCUNode(K, T);
+    public:
+    /**
+     * The key.
+     */
+    K               key;
+    /**
+     * The value.
+     */
+    T               val;
+    /**
+     * The children, D of them.
+     */
+    RCUNode*        child[1];
+
+    static RCUNode* create(K, T, const vector<int>&);
+    static RCUNode* copy(RCUNode*, int);
+    static void     destroy(RCUNode*);
+    int*            coordinates(int);
+};
+
+/**
+ * RCUNode constructor.
+ * @param key The key.
+ * @param val The value.
+ */
+template <class T, class K>
+RCUNode<T, K>::RCUNode (K key, T val)
+    : key(key), val(val)
+{
+}
+
+/**
+ * Creates a Node without children.
+ * @param key The key.
+ * @param val The value.
+ * @param coordinates Coordinates of key, one per dimension.
+ * @returns The Node, to be freed with destroy.
+ */
+template <class T, class K>
+RCUNode<T, K>* RCUNode<T, K>::create (K key, T val, const vector<int>& coordinates)
+{
+    int D = coordinates.size();
+    size_t size = sizeof(RCUNode) + (D - 1) * sizeof(RCUNode*) + D * sizeof(int);
+    RCUNode* node = new (::operator new(size)) RCUNode(key, val);
+    for (int d = 0; d < D; d++)
+        node->child[d] = NULL;
+    std::copy(coordinates.begin(), coordinates.end(), node->coordinates(D));
+    return node;
+}
+
+/**
+ * Copies a Node, with the same children.
+ * @param node The Node.
+ * @param D Number of dimensions.
+ * @returns The copy.
+ */
+template <class T, class K>
+RCUNode<T, K>* RCUNode<T, K>::copy (RCUNode* node, int D)
+{
+    int* coordinates = node->coordinates(D);
+    RCUNode* copy = create(node->key, node->val,
+                           vector<int>(coordinates, coordinates + D));
+    std::copy(node->child, node->child + D, copy->child);
+    return copy;
+}
+
+/**
+ * Frees a Node.
+ * @param node The Node.
+ */
+template <class T, class K>
+void RCUNode<T, K>::destroy (RCUNode* node)
+{
+    node->~RCUNode();
+    ::operator delete(node);
+}
+
+/**
+ * Getter for coordinates.
+ * @param D Number of dimensions.
+ * @returns The first coordinate.
+ */
+template <class T, class K>
+int* RCUNode<T, K>::coordinates (int D)
+{
+    return (int*) (this->child + D);
+}
+
+/**
+ * RCUReaders class.
+ * Grace periods for RCUMDList readers. Each reader thread owns
+ * a slot, taken on its first read and released when it exits,
+ * so entering and leaving a read section are plain stores to
+ * that slot, with no read-modify-write on shared memory. Where
+ * the system has an expedited membarrier, synchronize makes
+ * every running thread execute a full barrier, so readers
+ * need none. Otherwise each reader fences on enter.
+ * Grace periods are shared by every RCUMDList.
+ */
+class RCUReaders
+{
+    /**
+     * Slot of a reader thread.
+     * Padded to a cache line to avoid false sharing.
+     */
+    struct alignas(CACHE_LINE) Slot
+    {
+        /**
+         * The global epoch when the owner entered its read
+         * section, 0 while it is not reading.
+         */
+        std::atomic<ULL>    epoch;
+        /**
+         * Whether a thread owns the slot.
+         */
+        std::atomic<bool>   used;
+        /**
+         * Number of read sections the owner is in.
+         */
+        int                 depth;
+        /**
+         * The slot taken before this one.
+         */
+        Slot*               next;
+    };
+    /**
+     * Releases the slot of a thread when it exits.
+     */
+    struct Owner
+    {
+        Slot*               slot;
+                            ~Owner()
+                            {
+                                this->slot->used.store(false);
+                            }
+    };
+    static std::atomic<Slot*>&
+                            slots();
+    static std::atomic<ULL>&
+                            epoch();
+    static Slot*            take();
+    static Slot*            mine();
+    static bool             expedited();
+    public:
+    static void             enter();
+    static void             exit();
+    static void             synchronize();
+};
+
+/**
+ * The slots, every slot ever taken. Slots are reused
+ * by later threads and never freed.
+ * @returns Reference to the first slot.
+ */
+inline std::atomic<RCUReaders::Slot*>& RCUReaders::slots ()
+{
+    static std::atomic<Slot*> slots(NULL);
+    return slots;
+}
+
+/**
+ * The global epoch, advanced by every grace period.
+ * @returns Reference to the epoch.
+ */
+inline std::atomic<ULL>& RCUReaders::epoch ()
+{
+    static std::atomic<ULL> epoch(1);
+    return epoch;
+}
+
+/**
+ * Takes a slot released by an exited thread, or a new one.
+ * @returns The slot.
+ */
+inline RCUReaders::Slot* RCUReaders::take ()
+{
+    for (Slot* slot = slots().load(); slot != NULL; slot = slot->next)
+        if (!slot->used.load() && !slot->used.exchange(true))
+            return slot;
+    void* memory = aligned_alloc(CACHE_LINE, sizeof(Slot));
+    if (memory == NULL)
+        throw std::bad_alloc();
+    Slot* slot = new (memory) Slot();
+    slot->epoch = 0;
+    slot->used = true;
+    slot->depth = 0;
+    slot->next = slots().load();
+    while (!slots().compare_exchange_weak(slot->next, slot));
+    return slot;
+}
+
+/**
+ * Getter for the slot of the current thread.
+ * @returns The slot, taken on first use.
+ */
+inline RCUReaders::Slot* RCUReaders::mine ()
+{
+    static thread_local Owner owner = {take()};
+    return owner.slot;
+}
+
+/**
+ * Registers the process for expedited membarrier, once.
+ * @returns True if synchronize can issue one else False.
+ */
+inline bool RCUReaders::expedited ()
+{
+#if defined(__linux__) && defined(__NR_membarrier)
+    static const bool registered =
+        syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0;
+    return registered;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Enters a read section of the current thread.
+ * Sections may nest.
+ */
+inline void RCUReaders::enter ()
+{
+    Slot* slot = mine();
+    if (slot->depth++ == 0)
+    {
+        slot->epoch.store(epoch().load(), std::memory_order_relaxed);
+        // Orders the store before the reads of the section,
+        // paired with the membarrier or fence in synchronize.
+        if (expedited())
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        else
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+/**
+ * Leaves a read section of the current thread.
+ */
+inline void RCUReaders::exit ()
+{
+    Slot* slot = mine();
+    if (--slot->depth == 0)
+        slot->epoch.store(0, std::memory_order_release);
+}
+
+/**
+ * Waits until every read section which was running at
+ * the call has left. Sections entered later see every
+ * store made before the call.
+ * Must not be called inside a read section.
+ */
+inline void RCUReaders::synchronize ()
+{
+    ULL target = epoch().fetch_add(1) + 1;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+#if defined(__linux__) && defined(__NR_membarrier)
+    if (expedited())
+        syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0);
+#endif
+    for (Slot* slot = slots().load(); slot != NULL; slot = slot->next)
+    {
+        ULL e = slot->epoch.load(std::memory_order_acquire);
+        while (e != 0 && e < target)
+        {
+            std::this_thread::yield();
+            e = slot->epoch.load(std::memory_order_acquire);
+        }
+    }
+}
+
+/**
+ * RCUReadGuard class.
+ * Keeps the Nodes a reader can see alive while in scope.
+ */
+class RCUReadGuard
+{
+    public:
+    /**
+     * RCUReadGuard constructor.
+     */
+                            RCUReadGuard()
+                            {
+                                RCUReaders::enter();
+                            }
+    /**
+     * RCUReadGuard destructor.
+     */
+                            ~RCUReadGuard()
+                            {
+                                RCUReaders::exit();
+                            }
+};
+
+/**
+ * RCUMDList class.
+ * MDList for workloads which update rarely, in batches, and
+ * read a lot. Lookups take no locks and only store to a slot of
+ * their own thread, see RCUReaders. Writers are serialized, and
+ * each insert, remove or multiUpdate copies the paths it changes
+ * and publishes them at once. Writers then wait until readers
+ * of the old version are done, and free the replaced Nodes.
+ */
+template <class T, class Codec = UnsignedCodec>
+class RCUMDList
+{
+    /**
+     * Type of codes, see Codec.
+     */
+    typedef typename Codec::Code Code;
+    /**
+     * A published version, never changed.
+     */
+    struct Version
+    {
+        /**
+         * The D value of MDList.
+         */
+        int                     D;
+        /**
+         * The key space, 0 if it holds every Code.
+         */
+        Code                    N;
+        /**
+         * Root of the MDList, with key 0.
+         */
+        RCUNode<T, Code>*       root;
+
+        /**
+         * Checks if key is in the key space.
+         * @param key The key.
+         * @returns True if key is in the key space.
+         */
+        bool                    contains(Code key)
+                                {
+                                    return this->N == 0 || key < this->N;
+                                }
+    };
+    /**
+     * A version replaced by a writer, with the Nodes
+     * no longer in the new version.
+     */
+    struct Garbage
+    {
+        Version*                version;
+        vector<RCUNode<T, Code>*>
+                                nodes;
+    };
+    /**
+     * A version being built by a writer.
+     */
+    struct Batch
+    {
+        /**
+         * The new version, not yet published.
+         */
+        Version*                version;
+        /**
+         * Nodes created for the new version, which
+         * the writer may still change.
+         */
+        std::unordered_set<RCUNode<T, Code>*>
+                                fresh;
+        /**
+         * The replaced version.
+         */
+        Garbage*                garbage;
+    };
+    /**
+     * The published version.
+     */
+    std::atomic<Version*>       version;
+    /**
+     * Range of a coordinate, fixed as the key space grows.
+     */
+    ULL                         M;
+    /**
+     * Mutex lock for writers.
+     */
+    std::mutex                  writer_mutex;
+    static void                 destroyGarbage(Garbage*);
+    void                        begin(Batch&);
+    void                        publish(Batch&);
+    void                        grow(Batch&, Code);
+    RCUNode<T, Code>*           own(Batch&, RCUNode<T, Code>*);
+    RCUNode<T, Code>*           locate(Batch&, const vector<int>&, int&,
+                                       RCUNode<T, Code>*&);
+    T                           put(Batch&, Code, T);
+    T                           erase(Batch&, Code);
+    public:
+    /**
+     * Type of keys.
+     */
+    typedef typename Codec::Key Key;
+                                RCUMDList(int, Code);
+                                RCUMDList(const RCUMDList&) = delete;
+    RCUMDList&                  operator=(const RCUMDList&) = delete;
+                                ~RCUMDList();
+    void                        insert(Key, T);
+    T                           find(Key);
+    T                           remove(Key);
+    vector<T>                   multiUpdate(vector< UpdateOp<T, Key> >);
+    void                        clear();
+    void                        eraseRange(Key, Key);
+    int                         getD();
+    Code                        getN();
+};
+
+/**
+ * RCUMDList constructor.
+ * The key space is rounded up as in MDList, and grows
+ * as in MDList when a larger key is inserted.
+ * @param D The D value of MDList.
+ * @param N The initial key space.
+ */
+template <class T, class Codec>
+RCUMDList<T, Codec>::RCUMDList (int D, Code N)
+{
+    this->M = max(nthRoot(N, D), 2L);
+    if (keySpaceSize<Code>(this->M, D) != 0 && keySpaceSize<Code>(this->M, D) < N)
+        this->M++;
+    Version* version = new Version();
+    version->D = D;
+    version->N = keySpaceSize<Code>(this->M, D);
+    version->root = RCUNode<T, Code>::create(0, NULL, vector<int>(D, 0));
+    this->version = version;
+}
+
+/**
+ * RCUMDList destructor.
+ * Frees every Node. No operation may be running.
+ */
+template <class T, class Codec>
+RCUMDList<T, Codec>::~RCUMDList ()
+{
+    Version* version = this->version.load();
+    vector<RCUNode<T, Code>*> stack(1, version->root);
+    while (stack.size() > 0)
+    {
+        RCUNode<T, Code>* node = stack.back();
+        stack.pop_back();
+        for (int d = 0; d < version->D; d++)
+            if (node->child[d] != NULL)
+                stack.push_back(node->child[d]);
+        RCUNode<T, Code>::destroy(node);
+    }
+    delete version;
+}
+
+/**
+ * Frees a replaced version and its Nodes.
+ * @param garbage The Garbage.
+ */
+template <class T, class Codec>
+void RCUMDList<T, Codec>::destroyGarbage (Garbage* garbage)
+{
+    for (size_t i = 0; i < garbage->nodes.size(); i++)
+        RCUNode<T, Code>::destroy(garbage->nodes[i]);
+    delete garbage->version;
+    delete garbage;
+}
+
+/**
+ * Starts a new version from the published one.
+ * Locks the writer mutex.
+ * @param batch Gets the new version.
+ */
+template <class T, class Codec>
+void RCUMDList<T, Codec>::begin (Batch& batch)
+{
+    this->writer_mutex.lock();
+    Version* version = this->version.load();
+    batch.version = new Version(*version);
+    batch.fresh.clear();
+    batch.garbage = new Garbage();
+    batch.garbage->version = version;
+}
+
+/**
+ * Publishes the new version and unlocks the writer mutex.
+ * Waits until no reader can see the replaced Nodes, and
+ * frees them.
+ * @param batch The new version.
+ */
+template <class T, class Codec>
+void RCUMDList<T, Codec>::publish (Batch& batch)
+{
+    this->version.store(batch.version, std::memory_order_release);
+    this->writer_mutex.unlock();
+    RCUReaders::synchronize();
+    destroyGarbage(batch.garbage);
+}
+
+/**
+ * Gets a Node of the new version which the writer may change.
+ * A published Node is copied, and replaced when published.
+ * The caller links the copy in place of the Node.
+ * @param batch The new version.
+ * @param node The Node.
+ * @returns The Node, or its copy.
+ */
+template <class T, class Codec>
+RCUNode<T, typename Codec::Code>*
+RCUMDList<T, Codec>::own (Batch& batch, RCUNode<T, Code>* node)
+{
+    if (batch.fresh.count(node) > 0)
+        return node;
+    RCUNode<T, Code>* copy = RCUNode<T, Code>::copy(node, batch.version->D);
+    batch.fresh.insert(copy);
+    batch.garbage->nodes.push_back(node);
+    return copy;
+}
+
+/**
+ * Locates predecessor and current of given coordinates in the
+ * new version, as MDList::locatePredecessor. The path from root
+ * to predecessor is owned by the writer, current is not.
+ * @param batch The new version.
+ * @param coordinates The coordinates, not those of root.
+ * @param dim Gets the dimension of current in predecessor.
+ * @param current Gets current, NULL if there is none.
+ * @returns The predecessor.
+ */
+template <class T, class Codec>
+RCUNode<T, typename Codec::Code>*
+RCUMDList<T, Codec>::locate (Batch& batch, const vector<int>& coordinates,
+                             int& dim, RCUNode<T, Code>*& current)
+{
+    int D = batch.version->D;
+    batch.version->root = this->own(batch, batch.version->root);
+    RCUNode<T, Code>* predecessor = NULL;
+    current = batch.version->root;
+    int d = 0;
+    while (d < D)
+    {
+        while (current != NULL && coordinates[d] > current->coordinates(D)[d])
+        {
+            // Owns current before stepping below it.
+            if (predecessor != NULL)
+            {
+                current = this->own(batch, current);
+                predecessor->child[dim] = current;
+            }
+            predecessor = current;
+            dim = d;
+            current = current->child[d];
+        }
+        if (current == NULL || coordinates[d] < current->coordinates(D)[d])
+            break;
+        d++;
+    }
+    return predecessor;
+}
+
+/**
+ * Inserts (key, value) to the new version.
+ * @param batch The new version.
+ * @param key The encoded key, in the key space.
+ * @param val The value.
+ * @returns The previous value, NULL if key was absent.
+ */
+template <class T, class Codec>
+T RCUMDList<T, Codec>::put (Batch& batch, Code key, T val)
+{
+    int D = batch.version->D;
+    if (key == 0)
+    {
+        batch.version->root = this->own(batch, batch.version->root);
+        T previous = batch.version->root->val;
+        batch.version->root->val = val;
+        return previous;
+    }
+    vector<int> coordinates = keyToDigits(key, D, this->M);
+    int dim;
+    RCUNode<T, Code>* current;
+    RCUNode<T, Code>* predecessor = this->locate(batch, coordinates, dim, current);
+    if (current != NULL && current->key == key)
+    {
+        current = this->own(batch, current);
+        predecessor->child[dim] = current;
+        T previous = current->val;
+        current->val = val;
+        return previous;
+    }
+    RCUNode<T, Code>* node = RCUNode<T, Code>::create(key, val, coordinates);
+    batch.fresh.insert(node);
+    if (current != NULL)
+    {
+        // Node takes the place of current, and the
+        // children of current it comes before.
+        int d = dim;
+        while (coordinates[d] >= current->coordinates(D)[d])
+            d++;
+        if (d > dim)
+            current = this->own(batch, current);
+        for (int i = dim; i < d; i++)
+        {
+            node->child[i] = current->child[i];
+            current->child[i] = NULL;
+        }
+        node->child[d] = current;
+    }
+    predecessor->child[dim] = node;
+    return NULL;
+}
+
+/**
+ * Removes key from the new version.
+ * @param batch The new version.
+ * @param key The encoded key, in the key space.
+ * @returns The value if key was present else NULL.
+ */
+template <class T, class Codec>
+T RCUMDList<T, Codec>::erase (Batch& batch, Code key)
+{
+    int D = batch.version->D;
+    // Root cannot be removed, only its value.
+    if (key == 0)
+        return this->put(batch, 0, NULL);
+    vector<int> coordinates = keyToDigits(key, D, this->M);
+    int dim;
+    RCUNode<T, Code>* current;
+    RCUNode<T, Code>* predecessor = this->locate(batch, coordinates, dim, current);
+    if (current == NULL || current->key != key)
+        return NULL;
+    // The last indexed child of current takes its
+    // place, with the children of current before it.
+    RCUNode<T, Code>* next = NULL;
+    int d = D;
+    while (d > 0 && next == NULL)
+        next = current->child[--d];
+    if (next != NULL)
+    {
+        next = this->own(batch, next);
+        for (int i = dim; i < d; i++)
+            next->child[i] = current->child[i];
+    }
+    predecessor->child[dim] = next;
+    T val = current->val;
+    if (batch.fresh.erase(current) > 0)
+        RCUNode<T, Code>::destroy(current);
+    else
+        batch.garbage->nodes.push_back(current);
+    return val;
+}
+
+/**
+ * Grows the key space of the new version until it contains
+ * the given key, as MDList does. Every Node is copied, with a
+ * leading coordinate 0 and its children moved up one dimension.
+ * @param batch The new version.
+ * @param key The key.
+ */
+template <class T, class Codec>
+void RCUMDList<T, Codec>::grow (Batch& batch, Code key)
+{
+    Version* version = batch.version;
+    while (!version->contains(key))
+    {
+        int D = version->D;
+        version->D = D + 1;
+        version->N = version->N > maxCode<Code>() / this->M ? 0 : version->N * this->M;
+        // Stack of (old Node, where its copy goes).
+        vector< pair<RCUNode<T, Code>*, RCUNode<T, Code>**> > stack;
+        stack.push_back(make_pair(version->root, &version->root));
+        while (stack.size() > 0)
+        {
+            RCUNode<T, Code>* node = stack.back().first;
+            RCUNode<T, Code>** slot = stack.back().second;
+            stack.pop_back();
+            vector<int> coordinates(1, 0);
+            coordinates.insert(coordinates.end(), node->coordinates(D),
+                               node->coordinates(D) + D);
+            RCUNode<T, Code>* copy = RCUNode<T, Code>::create(node->key, node->val, coordinates);
+            *slot = copy;
+            for (int d = 0; d < D; d++)
+                if (node->child[d] != NULL)
+                    stack.push_back(make_pair(node->child[d], &copy->child[d + 1]));
+            // Copies made by an earlier step are not published.
+            if (batch.fresh.erase(node) > 0)
+                RCUNode<T, Code>::destroy(node);
+            else
+                batch.garbage->nodes.push_back(node);
+            batch.fresh.insert(copy);
+        }
+    }
+}
+
+/**
+ * Insert (key, value) to RCUMDList.
+ * @param key The key.
+ * @param val The value.
+ */
+template <class T, class Codec>
+void RCUMDList<T, Codec>::insert (Key key, T val)
+{
+    vector< UpdateOp<T, Key> > ops(1);
+    ops[0].key = key;
+    ops[0].val = val;
+    ops[0].remove = false;
+    this->multiUpdate(ops);
+}
+
+/**
+ * Searches for given key.
+ * @param key The key.
+ * @returns The value if key is present else NULL.
+ */
+template <class T, class Codec>
+T RCUMDList<T, Codec>::find (Key key)
+{
+    Code code = Codec::encode(key);
+    RCUReadGuard guard;
+    Version* version = this->version.load(std::memory_order_acquire);
+    if (!version->contains(code))
+        return NULL;
+    int D = version->D;
+    vector<int> coordinates = keyToDigits(code, D, this->M);
+    RCUNode<T, Code>* current = version->root;
+    int d = 0;
+    while (d < D)
+    {
+        while (current != NULL && coordinates[d] > current->coordinates(D)[d])
+            current = current->child[d];
+        if (current == NULL || coordinates[d] < current->coordinates(D)[d])
+            return NULL;
+        d++;
+    }
+    return current->val;
+}
+
+/**
+ * Removes the given key.
+ * @param key The key.
+ * @returns The value if key present and removed else NULL.
+ */
+template <class T, class Codec>
+T RCUMDList<T, Codec>::remove (Key key)
+{
+    vector< UpdateOp<T, Key> > ops(1);
+    ops[0].key = key;
+    ops[0].val = NULL;
+    ops[0].remove = true;
+    return this->multiUpdate(ops)[0];
+}
+
+/**
+ * Applies a group of inserts and removes atomically, in
+ * one new version. Readers see either none or all of them.
+ * @param ops The operations, each on a different key.
+ * @returns The previous value of each key, in the order of ops.
+ */
+template <class T, class Codec>
+vector<T> RCUMDList<T, Codec>::multiUpdate (vector< UpdateOp<T, Key> > ops)
+{
+    size_t n = ops.size();
+    vector<T> previous(n, NULL);
+    if (n == 0)
+        return previous;
+    vector<Code> codes(n);
+    for (size_t i = 0; i < n; i++)
+        codes[i] = Codec::encode(ops[i].key);
+    vector<Code> sorted = codes;
+    sort(sorted.begin(), sorted.end());
+    if (adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+        throw "Duplicate key in multiUpdate";
+    Batch batch;
+    this->begin(batch);
+    this->grow(batch, sorted[n - 1]);
+    for (size_t i = 0; i < n; i++)
+    {
+        if (ops[i].remove)
+            previous[i] = this->erase(batch, codes[i]);
+        else
+            previous[i] = this->put(batch, codes[i], ops[i].val);
+    }
+    this->publish(batch);
+    return previous;
+}
+
+/**
+ * Removes all (key, value) pairs.
+ */
+template <class T, class Codec>
+void RCUMDList<T, Codec>::clear ()
+{
+    Batch batch;
+    this->begin(batch);
+    Version* version = batch.version;
+    vector<RCUNode<T, Code>*> stack(1, version->root);
+    while (stack.size() > 0)
+    {
+        RCUNode<T, Code>* node = stack.back();
+        stack.pop_back();
+        for (int d = 0; d < version->D; d++)
+            if (node->child[d] != NULL)
+                stack.push_back(node->child[d]);
+        batch.garbage->nodes.push_back(node);
+    }
+    version->root = RCUNode<T, Code>::create(0, NULL, vector<int>(version->D, 0));
+    this->publish(batch);
+}
+
+/**
+ * Removes all keys in range [lo, hi], in one new version.
+ * Subtrees which lie outside the range are skipped.
+ * @param lo_key The lowest key to remove.
+ * @param hi_key The highest key to remove.
+ */
+template <class T, class Codec>
+void RCUMDList<T, Codec>::eraseRange (Key lo_key, Key hi_key)
+{
+    Code lo = Codec::encode(lo_key), hi = Codec::encode(hi_key);
+    Batch batch;
+    this->begin(batch);
+    Version* version = batch.version;
+    int D = version->D;
+    vector<Code> keys;
+    if (lo <= hi && version->contains(lo))
+    {
+        // Stack of (node, dimension it was reached by).
+        vector< pair<RCUNode<T, Code>*, int> > stack;
+        stack.push_back(make_pair(version->root, 0));
+        while (stack.size() > 0)
+        {
+            RCUNode<T, Code>* node = stack.back().first;
+            int dim = stack.back().second;
+            stack.pop_back();
+            if (node->key >= lo && node->key <= hi)
+                keys.push_back(node->key);
+            int* coordinates = node->coordinates(D);
+            vector<int> prefix(coordinates, coordinates + D);
+            for (int d = dim; d < D; d++)
+            {
+                RCUNode<T, Code>* child = node->child[d];
+                // Keys below child are in [child key, last].
+                if (child != NULL && child->key <= hi &&
+                        prefixMaxKey<Code>(prefix, d, D, this->M) >= lo)
+                    stack.push_back(make_pair(child, d));
+            }
+        }
+    }
+    for (size_t i = 0; i < keys.size(); i++)
+        this->erase(batch, keys[i]);
+    this->publish(batch);
+}
+
+/**
+ * Getter for D.
+ * @returns D value of RCUMDList.
+ */
+template <class T, class Codec>
+int RCUMDList<T, Codec>::getD ()
+{
+    RCUReadGuard guard;
+    return this->version.load()->D;
+}
+
+/**
+ * Getter for key space.
+ * @returns Size of the current key space, 0 if it holds every Code.
+ */
+template <class T, class Codec>
+typename Codec::Code RCUMDList<T, Codec>::getN ()
+{
+    RCUReadGuard guard;
+    return this->version.load()->N;
+}
+
+#endif
@@ -0,0 +1,291 @@
+/**
+ * @file mdlist_trace.h
+ * @brief Recording of MDList operations to a binary trace,
+ * which tests/trace_replay_test.cpp replays.
+ *
+ * A trace file is a 16 byte header, "MDLTRACE" followed by the
+ * format version and the record size as 32 bit integers, and
+ * then fixed size TraceRecords in host byte order. Records of
+ * different threads are not sorted by time.
+ */
+
+#ifndef _mdlist_trace_h_
+#define _mdlist_trace_h_
+
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <chrono>
+#include "mdlist.h"
+
+#define TRACE_MAGIC "MDLTRACE"
+#define TRACE_VERSION 1
+
+/**
+ * Number of record buffers of a TracedMDList.
+ * Threads are spread over the buffers to avoid
+ * contention on a single lock.
+ */
+#define TRACE_SLOTS 16
+
+/**
+ * Number of records a buffer holds before it is
+ * written to the trace file.
+ */
+#define TRACE_BUFFER 4096
+
+/**
+ * Type of a traced operation.
+ */
+enum TraceOp
+{
+    TRACE_INSERT = 0,
+    TRACE_FIND = 1,
+    TRACE_REMOVE = 2
+};
+
+/**
+ * A traced operation.
+ */
+struct TraceRecord
+{
+    /**
+     * Start of operation, in nanoseconds since the trace started.
+     */
+    ULL             time;
+    /**
+     * The key.
+     */
+    ULL             key;
+    /**
+     * Id of the thread, numbered from 0 in order of first use.
+     */
+    uint32_t        thread;
+    /**
+     * The TraceOp.
+     */
+    uint32_t        op;
+};
+
+/**
+ * Id of the current thread in traces.
+ * @returns The id.
+ */
+inline uint32_t traceThreadId ()
+{
+    static std::atomic<uint32_t> next(0);
+    static thread_local uint32_t id = next.fetch_add(1);
+    return id;
+}
+
+/**
+ * Reads a trace file.
+ * @param path The trace file.
+ * @returns The records, in file order.
+ */
+inline vector<TraceRecord> readTrace (const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+        throw "Cannot open trace file";
+    char magic[8];
+    uint32_t header[2];
+    if (fread(magic, 1, 8, file) != 8 || memcmp(magic, TRACE_MAGIC, 8) != 0 ||
+            fread(header, sizeof(uint32_t), 2, file) != 2 ||
+            header[0] != TRACE_VERSION || header[1] != sizeof(TraceRecord))
+    {
+        fclose(file);
+        throw "Invalid trace file";
+    }
+    vector<TraceRecord> records;
+    TraceRecord buffer[TRACE_BUFFER];
+    size_t n;
+    while ((n = fread(buffer, sizeof(TraceRecord), TRACE_BUFFER, file)) > 0)
+        records.insert(records.end(), buffer, buffer + n);
+    fclose(file);
+    return records;
+}
+
+/**
+ * TracedMDList class.
+ * MDList which records every insert, find and remove to
+ * a trace file. Values are not recorded. Operations on the
+ * underlying MDList from getList() are not recorded.
+ */
+template <class T>
+class TracedMDList
+{
+    /**
+     * Records not yet written, padded to a cache line.
+     */
+    struct alignas(64) Buffer
+    {
+        std::mutex              mutex;
+        vector<TraceRecord>     records;
+    };
+    /**
+     * The traced MDList.
+     */
+    MDList<T>                   list;
+    /**
+     * The trace file.
+     */
+    FILE*                       file;
+    /**
+     * Mutex lock for file.
+     */
+    std::mutex                  file_mutex;
+    /**
+     * The record buffers.
+     */
+    Buffer                      buffers[TRACE_SLOTS];
+    /**
+     * Start time of the trace.
+     */
+    std::chrono::steady_clock::time_point
+                                start;
+    void                        record(TraceOp, ULL);
+    void                        write(vector<TraceRecord>&);
+    public:
+                                TracedMDList(int, ULL, const char*);
+                                TracedMDList(const TracedMDList&) = delete;
+    TracedMDList&               operator=(const TracedMDList&) = delete;
+                                ~TracedMDList();
+    void                        insert(ULL, T);
+    T                           find(ULL);
+    T                           remove(ULL);
+    void                        flush();
+    MDList<T>&                  getList();
+};
+
+/**
+ * TracedMDList constructor.
+ * @param D The D value of MDList.
+ * @param N The initial key space.
+ * @param path The trace file, overwritten if it exists.
+ */
+template <class T>
+TracedMDList<T>::TracedMDList (int D, ULL N, const char* path)
+    : list(D, N)
+{
+    this->file = fopen(path, "wb");
+    if (this->file == NULL)
+        throw "Cannot open trace file";
+    uint32_t header[2] = {TRACE_VERSION, sizeof(TraceRecord)};
+    fwrite(TRACE_MAGIC, 1, 8, this->file);
+    fwrite(header, sizeof(uint32_t), 2, this->file);
+    for (int i = 0; i < TRACE_SLOTS; i++)
+        this->buffers[i].records.reserve(TRACE_BUFFER);
+    this->start = std::chrono::steady_clock::now();
+}
+
+/**
+ * TracedMDList destructor.
+ * Writes the remaining records and closes the trace file.
+ */
+template <class T>
+TracedMDList<T>::~TracedMDList ()
+{
+    this->flush();
+    fclose(this->file);
+}
+
+/**
+ * Records an operation which starts now.
+ * @param op The operation.
+ * @param key The key.
+ */
+template <class T>
+void TracedMDList<T>::record (TraceOp op, ULL key)
+{
+    TraceRecord r;
+    r.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 std::chrono::steady_clock::now() - this->start).count();
+    r.key = key;
+    r.thread = traceThreadId();
+    r.op = op;
+    Buffer& buffer = this->buffers[r.thread % TRACE_SLOTS];
+    buffer.mutex.lock();
+    buffer.records.push_back(r);
+    if (buffer.records.size() >= TRACE_BUFFER)
+        this->write(buffer.records);
+    buffer.mutex.unlock();
+}
+
+/**
+ * Appends records to the trace file and clears them.
+ * @param records The records.
+ */
+template <class T>
+void TracedMDList<T>::write (vector<TraceRecord>& records)
+{
+    this->file_mutex.lock();
+    fwrite(records.data(), sizeof(TraceRecord), records.size(), this->file);
+    this->file_mutex.unlock();
+    records.clear();
+}
+
+/**
+ * Insert (key, value) to MDList.
+ * @param key The key.
+ * @param val The value.
+ */
+template <class T>
+void TracedMDList<T>::insert (ULL key, T val)
+{
+    this->record(TRACE_INSERT, key);
+    this->list.insert(key, val);
+}
+
+/**
+ * Searches for given key.
+ * @param key The key.
+ * @returns The value if key is present else NULL.
+ */
+template <class T>
+T TracedMDList<T>::find (ULL key)
+{
+    this->record(TRACE_FIND, key);
+    return this->list.find(key);
+}
+
+/**
+ * Removes the given key.
+ * @param key The key.
+ * @returns The value if key present and removed else NULL.
+ */
+template <class T>
+T TracedMDList<T>::remove (ULL key)
+{
+    this->record(TRACE_REMOVE, key);
+    return this->list.remove(key);
+}
+
+/**
+ * Writes all buffered records to the trace file.
+ */
+template <class T>
+void TracedMDList<T>::flush ()
+{
+    for (int i = 0; i < TRACE_SLOTS; i++)
+    {
+        this->buffers[i].mutex.lock();
+        this->write(this->buffers[i].records);
+        this->buffers[i].mutex.unlock();
+    }
+    this->file_mutex.lock();
+    fflush(this->file);
+    this->file_mutex.unlock();
+}
+
+/**
+ * Getter for the traced MDList.
+ * @returns The MDList.
+ */
+template <class T>
+MDList<T>& TracedMDList<T>::getList ()
+{
+    return this->list;
+}
+
+#endif
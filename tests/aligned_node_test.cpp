@@ -0,0 +1,67 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE MDListTest
+#ifndef MDLIST_ALIGNED_NODES
+#define MDLIST_ALIGNED_NODES
+#endif
+#include <boost/test/unit_test.hpp>
+#include <vector>
+#include "../mdlist.h"
+using namespace std;
+
+#define RANGE 1000
+
+BOOST_AUTO_TEST_SUITE(MDListAlignedNodeTest)
+
+BOOST_AUTO_TEST_CASE(LayoutTest) {
+    vector<int> coordinates = {1, 2, 3, 4, 5, 6, 7, 8};
+    Node<int>* node = Node<int>::create(42, coordinates);
+    BOOST_CHECK_EQUAL(0, (uintptr_t) node % CACHE_LINE);
+    BOOST_CHECK_EQUAL(42, node->getKey());
+    BOOST_CHECK(coordinates == node->getCoordinates());
+    for (int d = 0; d < 8; d++)
+        BOOST_CHECK(node->getChild(d) == NULL);
+    // Children are allocated near their parent.
+    Node<int>* a = Node<int>::create(1, coordinates, node);
+    Node<int>* b = Node<int>::create(2, coordinates, node);
+    BOOST_CHECK_EQUAL(0, (uintptr_t) a % CACHE_LINE);
+    BOOST_CHECK_EQUAL((uintptr_t) node / ARENA_REGION_SIZE,
+                      (uintptr_t) a / ARENA_REGION_SIZE);
+    BOOST_CHECK_EQUAL((uintptr_t) node / ARENA_REGION_SIZE,
+                      (uintptr_t) b / ARENA_REGION_SIZE);
+    node->setChild(5, a);
+    node->setChild(1, b);
+    BOOST_CHECK_EQUAL(b, node->getChild(1));
+    BOOST_CHECK_EQUAL(a, node->getChild(5));
+    BOOST_CHECK(coordinates == node->getCoordinates());
+    node->setChild(1, NULL);
+    BOOST_CHECK(node->getChild(1) == NULL);
+    delete a;
+    delete b;
+    // Freed blocks are reused.
+    Node<int>* c = Node<int>::create(3, coordinates, node);
+    BOOST_CHECK(c == a || c == b);
+    delete c;
+    delete node;
+}
+
+BOOST_AUTO_TEST_CASE(RebuildTest) {
+    // Regions emptied by destroying a list are freed, or reused
+    // by the next list, so rebuilding does not grow the arena.
+    size_t first = 0;
+    for (int round = 0; round < 8; round++)
+    {
+        {
+            MDList<int> mdlist(8, 1LL << 32);
+            for (ULL i = 1; i <= 50*RANGE; i++)
+                mdlist.insert(i * 7919, i);
+            BOOST_CHECK(NodeArena::reserved() >= 50*RANGE * CACHE_LINE);
+        }
+        if (round == 0)
+            first = NodeArena::reserved();
+        BOOST_CHECK(NodeArena::reserved() <= first);
+    }
+    // Only the regions this thread allocates from are left.
+    BOOST_CHECK(NodeArena::reserved() <= 2 * ARENA_REGION_SIZE);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,73 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE MDListTest
+#include <boost/test/unit_test.hpp>
+#include <vector>
+#include "../mdlist.h"
+#include "test_threads.h"
+using namespace std;
+
+#define RANGE 1000
+#define N_THREADS 4
+
+BOOST_AUTO_TEST_SUITE(MDListCacheTest)
+
+BOOST_AUTO_TEST_CASE(HitMissTest) {
+    MDList<int> mdlist(8, 1LL << 32);
+    mdlist.enableCache(1024);
+    for (int i = 1; i < 64; i++)
+        mdlist.insert(i, i);
+    BOOST_CHECK_EQUAL(5, mdlist.find(5));
+    BOOST_CHECK_EQUAL(0, mdlist.cacheHits());
+    BOOST_CHECK_EQUAL(1, mdlist.cacheMisses());
+    BOOST_CHECK_EQUAL(5, mdlist.find(5));
+    BOOST_CHECK_EQUAL(1, mdlist.cacheHits());
+    // Updates of a cached key are seen.
+    mdlist.insert(5, 50);
+    BOOST_CHECK_EQUAL(50, mdlist.find(5));
+    // Removed keys are dropped from cache.
+    BOOST_CHECK_EQUAL(50, mdlist.remove(5));
+    BOOST_CHECK_EQUAL(NULL, mdlist.find(5));
+    mdlist.insert(5, 500);
+    BOOST_CHECK_EQUAL(500, mdlist.find(5));
+    BOOST_CHECK_EQUAL(500, mdlist.find(5));
+    mdlist.eraseRange(1, 63);
+    BOOST_CHECK_EQUAL(NULL, mdlist.find(5));
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentTest) {
+    MDList<int> mdlist(8, 1LL << 32);
+    mdlist.enableCache(64);
+    TestThreads threads;
+    for (int t = 0; t < N_THREADS; t++)
+    {
+        // Writers insert and remove their own keys repeatedly,
+        // while readers hit the same keys through the cache.
+        threads.spawn([&mdlist, t] () {
+            for (int r = 0; r < 10; r++)
+            {
+                for (int i = t*RANGE + 1; i <= (t+1)*RANGE; i++)
+                    mdlist.insert(i, i);
+                for (int i = t*RANGE + 1; i <= (t+1)*RANGE; i++)
+                    mdlist.remove(i);
+            }
+            return 0;
+        });
+        threads.spawn([&mdlist] () {
+            int wrong = 0;
+            for (int r = 0; r < 10; r++)
+                for (int i = 1; i <= N_THREADS*RANGE; i++)
+                {
+                    int val = mdlist.find(i);
+                    if (val != 0 && val != i)
+                        wrong++;
+                }
+            return wrong;
+        });
+    }
+    BOOST_CHECK_EQUAL(0, threads.join());
+    for (int i = 1; i <= N_THREADS*RANGE; i++)
+        BOOST_CHECK_EQUAL(NULL, mdlist.find(i));
+    BOOST_CHECK(mdlist.cacheHits() + mdlist.cacheMisses() > 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,217 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE MDListTest
+#include <boost/test/unit_test.hpp>
+#include <vector>
+#include <random>
+#include <limits>
+#include "../mdlist.h"
+#include "test_threads.h"
+using namespace std;
+
+#define D 8
+#define N 1000
+#define RANGE 1000
+#define N_THREADS 4
+
+/**
+ * Checks that codes of keys, given in increasing
+ * order, increase and decode to the keys.
+ */
+template <class Codec>
+void checkOrder (const vector<typename Codec::Key>& keys)
+{
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        BOOST_CHECK(Codec::decode(Codec::encode(keys[i])) == keys[i]);
+        if (i > 0)
+            BOOST_CHECK(Codec::encode(keys[i - 1]) < Codec::encode(keys[i]));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(MDListCodecTest)
+
+BOOST_AUTO_TEST_CASE(UnsignedTest) {
+    MDList<int> mdlist(D, N);
+    // Keys grow the key space up to every ULL.
+    mdlist.insert(ULLONG_MAX, 1);
+    mdlist.insert(ULLONG_MAX - 1, 2);
+    mdlist.insert(5, 3);
+    BOOST_CHECK_EQUAL(0, mdlist.getN());
+    BOOST_CHECK_EQUAL(1, mdlist.find(ULLONG_MAX));
+    BOOST_CHECK_EQUAL(2, mdlist.find(ULLONG_MAX - 1));
+    BOOST_CHECK_EQUAL(3, mdlist.find(5));
+    mdlist.eraseRange(ULLONG_MAX - 1, ULLONG_MAX);
+    BOOST_CHECK_EQUAL(NULL, mdlist.find(ULLONG_MAX));
+    BOOST_CHECK_EQUAL(NULL, mdlist.find(ULLONG_MAX - 1));
+    BOOST_CHECK_EQUAL(3, mdlist.find(5));
+    // A key space which does not fit in ULL holds every ULL.
+    MDList<int> full(8, ULLONG_MAX);
+    BOOST_CHECK_EQUAL(0, full.getN());
+    full.insert(ULLONG_MAX, 1);
+    BOOST_CHECK_EQUAL(1, full.find(ULLONG_MAX));
+}
+
+BOOST_AUTO_TEST_CASE(SignedTest) {
+    checkOrder< SignedCodec<long long> >({LLONG_MIN, -RANGE, -1, 0, 1, RANGE,
+                                          LLONG_MAX});
+    checkOrder< SignedCodec<int> >({INT_MIN, -1, 0, INT_MAX});
+    BOOST_CHECK_EQUAL(0, SignedCodec<int>::encode(INT_MIN));
+    BOOST_CHECK_EQUAL(1ULL << 31, SignedCodec<int>::encode(0));
+
+    MDList<int, SignedCodec<long long> > mdlist(D, N);
+    for (int i = -RANGE; i <= RANGE; i++)
+        mdlist.insert(i, i + 2*RANGE);
+    mdlist.insert(LLONG_MIN, 1);
+    mdlist.insert(LLONG_MAX, 2);
+    for (int i = -RANGE; i <= RANGE; i++)
+        BOOST_CHECK_EQUAL(i + 2*RANGE, mdlist.find(i));
+    BOOST_CHECK_EQUAL(1, mdlist.find(LLONG_MIN));
+    BOOST_CHECK_EQUAL(2, mdlist.find(LLONG_MAX));
+    // Ranges are ranges of keys.
+    mdlist.eraseRange(-10, 10);
+    for (int i = -RANGE; i <= RANGE; i++)
+        BOOST_CHECK_EQUAL(i >= -10 && i <= 10 ? 0 : i + 2*RANGE, mdlist.find(i));
+    // Traversals see keys, not codes.
+    long long sum = mdlist.parallel_reduce(0LL, [] (long long key, int val) {
+        return key == LLONG_MIN || key == LLONG_MAX ? 0 : key + val;
+    }, [] (long long a, long long b) { return a + b; });
+    BOOST_CHECK_EQUAL(2*RANGE * (2*RANGE + 1 - 21), sum);
+    BOOST_CHECK_EQUAL(-RANGE + 2*RANGE, mdlist.remove(-RANGE));
+    BOOST_CHECK_EQUAL(NULL, mdlist.find(-RANGE));
+}
+
+BOOST_AUTO_TEST_CASE(DoubleTest) {
+    double inf = numeric_limits<double>::infinity();
+    checkOrder<DoubleCodec>({-inf, -1e300, -2.5, -1.0, -1e-300, -0.0, 0.0,
+                             1e-300, 1.0, 2.5, 1e300, inf});
+    BOOST_CHECK_THROW(DoubleCodec::encode(numeric_limits<double>::quiet_NaN()),
+                      const char*);
+
+    MDList<int, DoubleCodec> mdlist(D, N);
+    for (int i = -RANGE; i <= RANGE; i++)
+        mdlist.insert(i / 8.0, i + 2*RANGE);
+    mdlist.insert(-inf, 1);
+    mdlist.insert(inf, 2);
+    for (int i = -RANGE; i <= RANGE; i++)
+        BOOST_CHECK_EQUAL(i + 2*RANGE, mdlist.find(i / 8.0));
+    BOOST_CHECK_EQUAL(NULL, mdlist.find(0.0625));
+    BOOST_CHECK_EQUAL(1, mdlist.find(-inf));
+    BOOST_CHECK_EQUAL(2, mdlist.find(inf));
+    mdlist.eraseRange(-1.0, 1.0);
+    for (int i = -RANGE; i <= RANGE; i++)
+        BOOST_CHECK_EQUAL(i >= -8 && i <= 8 ? 0 : i + 2*RANGE, mdlist.find(i / 8.0));
+    BOOST_CHECK_THROW(mdlist.find(numeric_limits<double>::quiet_NaN()), const char*);
+}
+
+#ifdef __SIZEOF_INT128__
+BOOST_AUTO_TEST_CASE(Int128Test) {
+    typedef unsigned __int128 U128;
+    U128 umax = ~(U128) 0;
+    checkOrder<UInt128Codec>({0, ULLONG_MAX, (U128) 1 << 64, umax});
+    // Keys past 64 bits grow the key space up to every code,
+    // in at most 64 dimensions for compact nodes.
+    MDList<int, UInt128Codec> umdlist(D, 1ULL << 32);
+    for (int i = 0; i < RANGE; i++)
+    {
+        umdlist.insert(i, i + 1);
+        umdlist.insert(((U128) i << 64) + i, i + 1);
+    }
+    umdlist.insert(umax, RANGE + 1);
+    BOOST_CHECK(umdlist.getN() == 0);
+    for (int i = 0; i < RANGE; i++)
+    {
+        BOOST_CHECK_EQUAL(i + 1, umdlist.find(i));
+        BOOST_CHECK_EQUAL(i + 1, umdlist.find(((U128) i << 64) + i));
+        BOOST_CHECK_EQUAL(NULL, umdlist.find(((U128) (i + RANGE) << 64) + i));
+    }
+    BOOST_CHECK_EQUAL(RANGE + 1, umdlist.find(umax));
+    // Keys which only differ above 64 bits are different.
+    umdlist.eraseRange((U128) 1 << 64, umax - 1);
+    for (int i = 0; i < RANGE; i++)
+    {
+        BOOST_CHECK_EQUAL(i + 1, umdlist.find(i));
+        BOOST_CHECK_EQUAL(i == 0 ? 1 : 0, umdlist.find(((U128) i << 64) + i));
+    }
+    BOOST_CHECK_EQUAL(RANGE + 1, umdlist.remove(umax));
+    umdlist.enableCache(64);
+    BOOST_CHECK_EQUAL(2, umdlist.find(1));
+    BOOST_CHECK_EQUAL(NULL, umdlist.find(((U128) 1 << 64) + 1));
+
+    __int128 big = (__int128) 1 << 100;
+    checkOrder<Int128Codec>({-big, -1, 0, 1, big});
+    MDList<int, Int128Codec> mdlist(D, 1ULL << 32);
+    mdlist.insert(-big, 1);
+    mdlist.insert(big, 2);
+    mdlist.insert(0, 3);
+    BOOST_CHECK_EQUAL(1, mdlist.find(-big));
+    BOOST_CHECK_EQUAL(2, mdlist.find(big));
+    BOOST_CHECK_EQUAL(3, mdlist.find(0));
+    BOOST_CHECK_EQUAL(NULL, mdlist.find(big + 1));
+    // Traversals see keys, not codes.
+    long long sum = mdlist.parallel_reduce(0LL, [big] (__int128 key, int val) {
+        return key == -big ? -val : key == big ? val * 10 : val * 100;
+    }, [] (long long a, long long b) { return a + b; });
+    BOOST_CHECK_EQUAL(-1 + 20 + 300, sum);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(CompositeTest) {
+    typedef CompositeCodec<16, 48> TenantCodec;
+    ULL max_id = (1ULL << 48) - 1;
+    checkOrder<TenantCodec>({{0, 0}, {0, 1}, {0, max_id}, {1, 0}, {1, max_id},
+                             {65535, 0}, {65535, max_id}});
+    BOOST_CHECK_THROW(TenantCodec::encode({65536, 0}), const char*);
+    BOOST_CHECK_THROW(TenantCodec::encode({0, max_id + 1}), const char*);
+    checkOrder< CompositeCodec<8, 8, 8> >({{0, 0, 1}, {0, 1, 0}, {1, 0, 0}});
+
+    MDList<int, TenantCodec> mdlist(D, N);
+    for (ULL tenant = 0; tenant < 4; tenant++)
+        for (ULL id = 0; id < RANGE; id++)
+            mdlist.insert({tenant, id * 1000003}, tenant * RANGE + id + 1);
+    for (ULL tenant = 0; tenant < 4; tenant++)
+        for (ULL id = 0; id < RANGE; id++)
+            BOOST_CHECK_EQUAL(tenant * RANGE + id + 1,
+                              mdlist.find({tenant, id * 1000003}));
+    // Removes every key of tenant 2.
+    mdlist.eraseRange({2, 0}, {2, max_id});
+    long count = mdlist.parallel_reduce(0L, [] (TenantCodec::Key key, int) {
+        return key[0] == 2 ? 1000000L : 1L;
+    }, [] (long a, long b) { return a + b; });
+    BOOST_CHECK_EQUAL(3 * RANGE, count);
+    vector< UpdateOp<int, TenantCodec::Key> > ops;
+    ops.push_back({{1, 0}, NULL, true});
+    ops.push_back({{2, 0}, 7, false});
+    vector<int> previous = mdlist.multiUpdate(ops);
+    BOOST_CHECK_EQUAL(RANGE + 1, previous[0]);
+    BOOST_CHECK_EQUAL(NULL, previous[1]);
+    BOOST_CHECK_EQUAL(NULL, mdlist.find({1, 0}));
+    BOOST_CHECK_EQUAL(7, mdlist.find({2, 0}));
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentSignedTest) {
+    // Growth to the full key space under concurrent use.
+    MDList<int, SignedCodec<long long> > mdlist(2, 4);
+    TestThreads threads;
+    for (int t = 0; t < N_THREADS; t++)
+        threads.spawn([&mdlist, t] () {
+            int wrong = 0;
+            mt19937_64 rng(t);
+            for (int i = 0; i < RANGE; i++)
+            {
+                // Even keys are shared, odd keys are per thread.
+                long long key = ((long long) rng() >> (i % 64)) & ~1LL;
+                mdlist.insert(key, 1);
+                if (mdlist.find(key) != 1)
+                    wrong++;
+                long long mine = (2 * (i * N_THREADS + t) + 1) * (i % 2 ? -1 : 1);
+                mdlist.insert(mine, i + 1);
+                if (mdlist.remove(mine) != i + 1)
+                    wrong++;
+            }
+            return wrong;
+        });
+    BOOST_CHECK_EQUAL(0, threads.join());
+    BOOST_CHECK_EQUAL(0, mdlist.getN());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,30 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE MDListTest
+#ifndef MDLIST_COMPACT_NODES
+#define MDLIST_COMPACT_NODES
+#endif
+#include <boost/test/unit_test.hpp>
+#include <vector>
+#include "../mdlist.h"
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(MDListCompactNodeTest)
+
+BOOST_AUTO_TEST_CASE(ChildTest) {
+    Node<int> node(0, 8, 1ULL << 32);
+    Node<int> a(1, 8, 1ULL << 32), b(2, 8, 1ULL << 32);
+    node.setChild(5, &a);
+    node.setChild(1, &b);
+    BOOST_CHECK_EQUAL(&b, node.getChild(1));
+    BOOST_CHECK_EQUAL(&a, node.getChild(5));
+    for (int d = 0; d < 8; d++)
+        if (d != 1 && d != 5)
+            BOOST_CHECK(node.getChild(d) == NULL);
+    node.setChild(1, NULL);
+    BOOST_CHECK(node.getChild(1) == NULL);
+    BOOST_CHECK_EQUAL(&a, node.getChild(5));
+    node.setChild(5, NULL);
+    BOOST_CHECK(node.getChild(5) == NULL);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,219 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "../mdlist.h"
+using namespace std;
+
+#define ULL unsigned long long
+
+#define D 8
+#define N (1LL << 32)
+#define N_COUNTERS 6
+
+// Sizes of MDList and numbers of threads to measure.
+const int SIZES[] = {1000, 10000, 100000, 1000000};
+const int THREADS[] = {1, 2, 4, 8};
+
+/**
+ * Hardware counters of the process, read with perf_event_open.
+ * Counters are inherited by threads created after open, so one
+ * set covers all workers. A counter which cannot be opened,
+ * e.g. without PMU access, is reported as n/a.
+ */
+class Counters
+{
+    int         fd[N_COUNTERS];
+    public:
+    static const char*
+                NAMES[N_COUNTERS];
+                Counters();
+                ~Counters();
+    bool        available(int);
+    void        start();
+    void        stop();
+    double      read(int);
+};
+
+const char* Counters::NAMES[N_COUNTERS] = {
+    "cycles", "instr", "L1D-miss", "LLC-miss", "dTLB-miss", "br-miss"
+};
+
+Counters::Counters ()
+{
+#ifdef __linux__
+    const uint64_t CACHE_READ_MISS = (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                     (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    uint32_t types[N_COUNTERS] = {
+        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+        PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE
+    };
+    uint64_t configs[N_COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_L1D | CACHE_READ_MISS,
+        PERF_COUNT_HW_CACHE_LL | CACHE_READ_MISS,
+        PERF_COUNT_HW_CACHE_DTLB | CACHE_READ_MISS,
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+    for (int i = 0; i < N_COUNTERS; i++)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = types[i];
+        attr.config = configs[i];
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+        fd[i] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+#else
+    for (int i = 0; i < N_COUNTERS; i++)
+        fd[i] = -1;
+#endif
+}
+
+Counters::~Counters ()
+{
+#ifdef __linux__
+    for (int i = 0; i < N_COUNTERS; i++)
+        if (fd[i] >= 0)
+            close(fd[i]);
+#endif
+}
+
+bool Counters::available (int i)
+{
+    return fd[i] >= 0;
+}
+
+void Counters::start ()
+{
+#ifdef __linux__
+    for (int i = 0; i < N_COUNTERS; i++)
+        if (fd[i] >= 0)
+        {
+            ioctl(fd[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+}
+
+void Counters::stop ()
+{
+#ifdef __linux__
+    for (int i = 0; i < N_COUNTERS; i++)
+        if (fd[i] >= 0)
+            ioctl(fd[i], PERF_EVENT_IOC_DISABLE, 0);
+#endif
+}
+
+/**
+ * Reads a counter, scaled up if it was multiplexed.
+ * Threads add to it when they exit, so read after join.
+ * @returns The count, -1 if not available.
+ */
+double Counters::read (int i)
+{
+#ifdef __linux__
+    // value, time enabled, time running
+    uint64_t data[3];
+    if (fd[i] < 0 || ::read(fd[i], data, sizeof(data)) != sizeof(data))
+        return -1;
+    if (data[2] == 0)
+        return 0;
+    return (double) data[0] * data[1] / data[2];
+#else
+    return -1;
+#endif
+}
+
+/**
+ * Runs op on keys split over threads, and prints
+ * wall time and counters per operation.
+ */
+template <class F>
+void measure (Counters& counters, const char* name, int size, int n_threads,
+              const vector<ULL>& keys, F op)
+{
+    vector<thread> threads;
+    counters.start();
+    auto begin_time = chrono::steady_clock::now();
+    for (int t = 0; t < n_threads; t++)
+        threads.push_back(thread([&, t] () {
+            for (size_t i = t; i < keys.size(); i += n_threads)
+                op(keys[i]);
+        }));
+    for (int t = 0; t < n_threads; t++)
+        threads[t].join();
+    double ns = chrono::duration<double, nano>(
+                    chrono::steady_clock::now() - begin_time).count();
+    counters.stop();
+    cout << left << setw(8) << name << right << setw(9) << size
+         << setw(8) << n_threads << fixed << setprecision(1)
+         << setw(10) << ns / size;
+    for (int i = 0; i < N_COUNTERS; i++)
+    {
+        double count = counters.read(i);
+        if (count < 0)
+            cout << setw(11) << "n/a";
+        else
+            cout << setw(11) << count / size;
+    }
+    cout << "\n";
+}
+
+int main ()
+{
+    Counters counters;
+    bool any = false;
+    for (int i = 0; i < N_COUNTERS; i++)
+        any = any || counters.available(i);
+    if (!any)
+        cout << "Hardware counters are not available (see "
+             << "/proc/sys/kernel/perf_event_paranoid), "
+             << "reporting wall time only\n";
+    cout << left << setw(8) << "op" << right << setw(9) << "size"
+         << setw(8) << "threads" << setw(10) << "ns/op";
+    for (int i = 0; i < N_COUNTERS; i++)
+        cout << setw(11) << Counters::NAMES[i];
+    cout << "\n";
+
+    mt19937_64 rng(42);
+    for (int size : SIZES)
+    {
+        // Random keys, so neighbouring operations
+        // do not share a path in the MDList.
+        vector<ULL> keys(size);
+        for (int i = 0; i < size; i++)
+            keys[i] = 1 + rng() % (N - 1);
+        sort(keys.begin(), keys.end());
+        keys.erase(unique(keys.begin(), keys.end()), keys.end());
+        shuffle(keys.begin(), keys.end(), rng);
+        for (int n_threads : THREADS)
+        {
+            MDList<ULL> mdlist(D, N);
+            measure(counters, "insert", keys.size(), n_threads, keys,
+                    [&] (ULL key) { mdlist.insert(key, key); });
+            measure(counters, "find", keys.size(), n_threads, keys,
+                    [&] (ULL key) { mdlist.find(key); });
+            measure(counters, "remove", keys.size(), n_threads, keys,
+                    [&] (ULL key) { mdlist.remove(key); });
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE MDListTest
+#include <boost/test/unit_test.hpp>
+#include <vector>
+#include <thread>
+#include "../mdlist.h"
+using namespace std;
+
+#define RANGE 1000
+#define N_THREADS 4
+
+BOOST_AUTO_TEST_SUITE(MDListEraseTest)
+
+BOOST_AUTO_TEST_CASE(ClearTest) {
+    MDList<int> mdlist(8, 1LL << 32);
+    for (int i = 1; i <= N_THREADS*RANGE; i++)
+        mdlist.insert(i, i);
+    mdlist.clear(N_THREADS);
+    for (int i = 0; i <= N_THREADS*RANGE; i++)
+        BOOST_CHECK_EQUAL(NULL, mdlist.find(i));
+    // The MDList is usable after clear.
+    for (int i = 1; i <= RANGE; i++)
+        mdlist.insert(i, i);
+    for (int i = 1; i <= RANGE; i++)
+        BOOST_CHECK_EQUAL(i, mdlist.find(i));
+}
+
+BOOST_AUTO_TEST_CASE(EraseRangeTest) {
+    MDList<int> mdlist(3, 64);
+    for (int lo = 0; lo < 64; lo += 7)
+    {
+        for (int hi = lo; hi < 64; hi += 5)
+        {
+            for (int i = 1; i < 64; i++)
+                mdlist.insert(i, i);
+            mdlist.eraseRange(lo, hi);
+            for (int i = 1; i < 64; i++)
+            {
+                if (i >= lo && i <= hi)
+                    BOOST_CHECK_EQUAL(NULL, mdlist.find(i));
+                else
+                    BOOST_CHECK_EQUAL(i, mdlist.find(i));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentEraseRangeTest) {
+    MDList<int> mdlist(8, 1LL << 32);
+    for (int i = 1; i <= N_THREADS*RANGE; i++)
+        mdlist.insert(i, i);
+    // Erase disjoint ranges while other threads read.
+    vector<thread> threads;
+    for (int t = 0; t < N_THREADS; t++)
+    {
+        threads.push_back(thread([&mdlist, t] () {
+            mdlist.eraseRange(t*RANGE + 1, t*RANGE + RANGE/2);
+        }));
+        threads.push_back(thread([&mdlist] () {
+            for (int i = 1; i <= N_THREADS*RANGE; i++)
+                mdlist.find(i);
+        }));
+    }
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+    for (int i = 1; i <= N_THREADS*RANGE; i++)
+    {
+        if ((i - 1) % RANGE < RANGE/2)
+            BOOST_CHECK_EQUAL(NULL, mdlist.find(i));
+        else
+            BOOST_CHECK_EQUAL(i, mdlist.find(i));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
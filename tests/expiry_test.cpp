@@ -0,0 +1,166 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE MDListTest
+#include <boost/test/unit_test.hpp>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include "../mdlist.h"
+using namespace std;
+
+#define D 8
+#define N 1000
+#define RANGE 1000
+#define N_THREADS 4
+
+typedef chrono::milliseconds ms;
+
+template <class T>
+long countKeys (MDList<T>& mdlist)
+{
+    return mdlist.parallel_reduce(0L, [] (ULL, T) { return 1L; },
+                                  [] (long a, long b) { return a + b; }, 1);
+}
+
+BOOST_AUTO_TEST_SUITE(MDListExpiryTest)
+
+BOOST_AUTO_TEST_CASE(TTLTest) {
+    MDList<int> mdlist(D, N);
+    mdlist.insert(1, 10, ms(50));
+    mdlist.insert(2, 20, ms(10000));
+    mdlist.insert(3, 30);
+    mdlist.insert(0, 5, ms(50));
+    BOOST_CHECK_EQUAL(10, mdlist.find(1));
+    BOOST_CHECK_EQUAL(5, mdlist.find(0));
+    this_thread::sleep_for(ms(80));
+    BOOST_CHECK_EQUAL(NULL, mdlist.find(1));
+    BOOST_CHECK_EQUAL(NULL, mdlist.find(0));
+    BOOST_CHECK_EQUAL(20, mdlist.find(2));
+    BOOST_CHECK_EQUAL(30, mdlist.find(3));
+    BOOST_CHECK_EQUAL(NULL, mdlist.remove(1));
+    BOOST_CHECK_EQUAL(2, countKeys(mdlist));
+    // Insert without TTL clears the expiry.
+    mdlist.insert(2, 21);
+    // Insert with a new TTL replaces the old one.
+    mdlist.insert(3, 31, ms(30));
+    mdlist.insert(3, 32, ms(10000));
+    this_thread::sleep_for(ms(80));
+    for (int i = 0; i < 100; i++)
+        mdlist.expire();
+    BOOST_CHECK_EQUAL(21, mdlist.find(2));
+    BOOST_CHECK_EQUAL(32, mdlist.find(3));
+    // Zero TTL expires at once.
+    mdlist.insert(4, 40, ms(0));
+    BOOST_CHECK_EQUAL(NULL, mdlist.find(4));
+}
+
+BOOST_AUTO_TEST_CASE(ExpireTest) {
+    MDList<int> mdlist(D, N);
+    // Long enough for the inserts, even on a loaded machine.
+    for (int i = 1; i <= RANGE; i++)
+        mdlist.insert(i, i, ms(500));
+    mdlist.setCapacity(RANGE);
+    BOOST_CHECK_EQUAL(RANGE, countKeys(mdlist));
+    this_thread::sleep_for(ms(600));
+    BOOST_CHECK_EQUAL(0, countKeys(mdlist));
+    // Expired keys are reclaimed, so new keys are not evicted.
+    for (int i = 0; i < RANGE; i++)
+        mdlist.expire();
+    for (int i = 1; i <= RANGE; i++)
+        mdlist.insert(RANGE + i, i);
+    for (int i = 1; i <= RANGE; i++)
+        BOOST_CHECK_EQUAL(i, mdlist.find(RANGE + i));
+}
+
+BOOST_AUTO_TEST_CASE(CapacityTest) {
+    MDList<int> mdlist(D, N);
+    mdlist.setCapacity(100);
+    for (int i = 1; i <= RANGE; i++)
+    {
+        mdlist.insert(i, i);
+        BOOST_REQUIRE(countKeys(mdlist) <= 100);
+    }
+    BOOST_CHECK_EQUAL(100, countKeys(mdlist));
+    // Lowering the capacity evicts at once.
+    mdlist.setCapacity(10);
+    BOOST_CHECK_EQUAL(10, countKeys(mdlist));
+    mdlist.setCapacity(0);
+    for (int i = 1; i <= RANGE; i++)
+        mdlist.insert(i, i);
+    BOOST_CHECK_EQUAL(RANGE, countKeys(mdlist));
+}
+
+BOOST_AUTO_TEST_CASE(EvictionOrderTest) {
+    // Keys which expire are evicted before those which do not.
+    MDList<int> mdlist(D, N);
+    for (int i = 1; i <= 150; i++)
+    {
+        if (i % 3 == 0)
+            mdlist.insert(i, i);
+        else
+            mdlist.insert(i, i, ms(10000));
+    }
+    mdlist.setCapacity(100);
+    BOOST_CHECK_EQUAL(100, countKeys(mdlist));
+    int kept = 0;
+    for (int i = 3; i <= 150; i += 3)
+        kept += mdlist.find(i) == i;
+    BOOST_CHECK(kept >= 45);
+}
+
+BOOST_AUTO_TEST_CASE(ByteBudgetTest) {
+    MDList<int> mdlist(D, N);
+    mdlist.setByteBudget(100 * 1024);
+    for (int i = 1; i <= 100*RANGE; i++)
+        mdlist.insert(i, i);
+    long keys = countKeys(mdlist);
+    BOOST_CHECK(keys > 100);
+    BOOST_CHECK(keys < 2000);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentExpiryTest) {
+    // Values index the inserts, and each insert records when it
+    // returned, after which its value expires by ttl at the latest.
+    // A value find returns must not have expired when find started.
+    MDList<ULL> mdlist(D, N);
+    mdlist.setCapacity(RANGE / 2);
+    const int n = 20*RANGE;
+    vector<ULL> done(N_THREADS * n);
+    // (value, start of find) of each find which found a value.
+    vector< vector< pair<ULL, ULL> > > found(N_THREADS);
+    vector<thread> threads;
+    for (int t = 0; t < N_THREADS; t++)
+    {
+        threads.push_back(thread([&mdlist, &done, t, n] () {
+            for (int i = 0; i < n; i++)
+            {
+                ULL key = 1 + (i * N_THREADS + t) % RANGE;
+                mdlist.insert(key, t*n + i + 1, ms(1 + i % 20));
+                done[t*n + i] = steadyNanos();
+            }
+        }));
+        threads.push_back(thread([&mdlist, &found, t, n] () {
+            for (int i = 0; i < n; i++)
+            {
+                ULL now = steadyNanos();
+                ULL val = mdlist.find(1 + i % RANGE);
+                if (val != 0)
+                    found[t].push_back(make_pair(val, now));
+            }
+        }));
+    }
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+    long late = 0;
+    for (int t = 0; t < N_THREADS; t++)
+        for (size_t j = 0; j < found[t].size(); j++)
+        {
+            ULL insert = found[t][j].first - 1;
+            ULL ttl = 1 + insert % n % 20;
+            if (found[t][j].second >= done[insert] + ttl * 1000000)
+                late++;
+        }
+    BOOST_CHECK_EQUAL(0, late);
+    BOOST_CHECK(countKeys(mdlist) <= RANGE / 2 + 2*N_THREADS);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
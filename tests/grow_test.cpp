@@ -0,0 +1,64 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE MDListTest
+#include <boost/test/unit_test.hpp>
+#include <vector>
+#include "../mdlist.h"
+#include "test_threads.h"
+using namespace std;
+
+#define RANGE 1000
+#define N_THREADS 4
+
+BOOST_AUTO_TEST_SUITE(MDListGrowTest)
+
+BOOST_AUTO_TEST_CASE(GrowTest) {
+    MDList<int> mdlist(2, 16);
+    BOOST_CHECK_EQUAL(2, mdlist.getD());
+    BOOST_CHECK_EQUAL(16, mdlist.getN());
+    for (int i = 0; i < 16; i++)
+        mdlist.insert(i, i + 1);
+    BOOST_CHECK_EQUAL(NULL, mdlist.find(100));
+    mdlist.insert(100, 101);
+    BOOST_CHECK_EQUAL(4, mdlist.getD());
+    BOOST_CHECK_EQUAL(256, mdlist.getN());
+    BOOST_CHECK_EQUAL(101, mdlist.find(100));
+    for (int i = 0; i < 16; i++)
+        BOOST_CHECK_EQUAL(i + 1, mdlist.find(i));
+    for (int i = 16; i < RANGE; i++)
+        mdlist.insert(i, i + 1);
+    for (int i = 0; i < RANGE; i++)
+        BOOST_CHECK_EQUAL(i + 1, mdlist.find(i));
+    for (int i = 0; i < RANGE; i += 2)
+        BOOST_CHECK_EQUAL(i + 1, mdlist.remove(i));
+    for (int i = 0; i < RANGE; i++)
+        BOOST_CHECK_EQUAL(i % 2 ? i + 1 : 0, mdlist.find(i));
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentGrowTest) {
+    MDList<int> mdlist(2, 4);
+    TestThreads threads;
+    for (int t = 0; t < N_THREADS; t++)
+    {
+        // Interleaved keys, so every thread triggers growth.
+        threads.spawn([&mdlist, t] () {
+            for (int i = t + 1; i <= N_THREADS*RANGE; i += N_THREADS)
+                mdlist.insert(i, i);
+            return 0;
+        });
+        threads.spawn([&mdlist] () {
+            int wrong = 0;
+            for (int i = 1; i <= N_THREADS*RANGE; i++)
+            {
+                int val = mdlist.find(i);
+                if (val != 0 && val != i)
+                    wrong++;
+            }
+            return wrong;
+        });
+    }
+    BOOST_CHECK_EQUAL(0, threads.join());
+    for (int i = 1; i <= N_THREADS*RANGE; i++)
+        BOOST_CHECK_EQUAL(i, mdlist.find(i));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,171 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE MDListTest
+#include <boost/test/unit_test.hpp>
+#include <vector>
+#include "../mdlist.h"
+#include "test_threads.h"
+using namespace std;
+
+#define D 8
+#define N 1000
+#define RANGE 1000
+#define N_THREADS 4
+
+BOOST_AUTO_TEST_SUITE(MDListMultiUpdateTest)
+
+BOOST_AUTO_TEST_CASE(MultiUpdateTest) {
+    MDList<int> mdlist(D, N);
+    mdlist.insert(1, 10);
+    mdlist.insert(2, 20);
+    vector< UpdateOp<int> > ops;
+    ops.push_back({3, 30, false});
+    ops.push_back({1, NULL, true});
+    ops.push_back({2, 21, false});
+    ops.push_back({4, NULL, true});
+    ops.push_back({0, 5, false});
+    vector<int> previous = mdlist.multiUpdate(ops);
+    BOOST_CHECK_EQUAL(5, previous.size());
+    BOOST_CHECK_EQUAL(NULL, previous[0]);
+    BOOST_CHECK_EQUAL(10, previous[1]);
+    BOOST_CHECK_EQUAL(20, previous[2]);
+    BOOST_CHECK_EQUAL(NULL, previous[3]);
+    BOOST_CHECK_EQUAL(NULL, previous[4]);
+    BOOST_CHECK_EQUAL(5, mdlist.find(0));
+    BOOST_CHECK_EQUAL(NULL, mdlist.find(1));
+    BOOST_CHECK_EQUAL(21, mdlist.find(2));
+    BOOST_CHECK_EQUAL(30, mdlist.find(3));
+    BOOST_CHECK_EQUAL(NULL, mdlist.find(4));
+    // Keys past the key space grow it.
+    ops.clear();
+    ops.push_back({0, NULL, true});
+    ops.push_back({5000, 50, false});
+    mdlist.multiUpdate(ops);
+    BOOST_CHECK_EQUAL(NULL, mdlist.find(0));
+    BOOST_CHECK_EQUAL(50, mdlist.find(5000));
+    BOOST_CHECK_EQUAL(21, mdlist.find(2));
+    // Duplicate keys are rejected without any change.
+    ops.clear();
+    ops.push_back({2, 22, false});
+    ops.push_back({2, NULL, true});
+    BOOST_CHECK_THROW(mdlist.multiUpdate(ops), const char*);
+    BOOST_CHECK_EQUAL(21, mdlist.find(2));
+    mdlist.insert(2, 23);
+    BOOST_CHECK_EQUAL(23, mdlist.remove(2));
+}
+
+BOOST_AUTO_TEST_CASE(AtomicVisibilityTest) {
+    MDList<int> mdlist(D, N);
+    mdlist.insert(10, 1);
+    mdlist.insert(900, 1);
+    TestThreads threads;
+    threads.spawn([&mdlist] () {
+        for (int v = 2; v <= RANGE*10; v++)
+        {
+            vector< UpdateOp<int> > ops;
+            ops.push_back({10, v, false});
+            ops.push_back({900, v, false});
+            mdlist.multiUpdate(ops);
+        }
+        return 0;
+    });
+    for (int t = 0; t < N_THREADS; t++)
+        threads.spawn([&mdlist] () {
+            int wrong = 0;
+            for (int i = 0; i < RANGE*10; i++)
+            {
+                // 900 is read later, so it is never older than 10.
+                int first = mdlist.find(10);
+                int second = mdlist.find(900);
+                if (first > second)
+                    wrong++;
+            }
+            return wrong;
+        });
+    BOOST_CHECK_EQUAL(0, threads.join());
+    BOOST_CHECK_EQUAL(RANGE*10, mdlist.find(10));
+    BOOST_CHECK_EQUAL(RANGE*10, mdlist.find(900));
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentMoveTest) {
+    // Each thread moves its tokens between its own keys,
+    // next to plain inserts and removes of other keys.
+    MDList<int> mdlist(D, N);
+    for (int i = 1; i <= RANGE; i++)
+        mdlist.insert(i, i);
+    TestThreads threads;
+    for (int t = 0; t < N_THREADS; t++)
+        threads.spawn([&mdlist, t] () {
+            int wrong = 0;
+            for (int i = 0; i < RANGE; i++)
+            {
+                ULL from = 1 + (i * 7 * N_THREADS + t) % RANGE;
+                ULL to = from + RANGE;
+                if (i % 2)
+                    swap(from, to);
+                int token = mdlist.find(from);
+                if (token == NULL)
+                    swap(from, to), token = mdlist.find(from);
+                vector< UpdateOp<int> > ops;
+                ops.push_back({from, NULL, true});
+                ops.push_back({to, token, false});
+                vector<int> previous = mdlist.multiUpdate(ops);
+                if (previous[0] != token || previous[1] != 0)
+                    wrong++;
+            }
+            return wrong;
+        });
+    for (int t = 0; t < N_THREADS; t++)
+        threads.spawn([&mdlist, t] () {
+            int wrong = 0;
+            for (int i = 1; i <= RANGE; i++)
+            {
+                ULL key = 3*RANGE + i*N_THREADS + t;
+                mdlist.insert(key, i);
+                if (mdlist.remove(key) != i)
+                    wrong++;
+            }
+            return wrong;
+        });
+    BOOST_CHECK_EQUAL(0, threads.join());
+    vector<int> seen(RANGE + 1, 0);
+    for (int i = 0; i <= 2*RANGE; i++)
+    {
+        int val = mdlist.find(i);
+        if (val != NULL)
+            seen[val]++;
+    }
+    for (int i = 1; i <= RANGE; i++)
+        BOOST_CHECK_EQUAL(1, seen[i]);
+}
+
+BOOST_AUTO_TEST_CASE(OverlappingUpdateTest) {
+    // Every group writes one value to all keys, or removes
+    // them all, so the keys must always end up equal.
+    MDList<int> mdlist(D, N);
+    vector<ULL> keys;
+    for (int i = 0; i < 16; i++)
+        keys.push_back(i * 61);
+    TestThreads threads;
+    for (int t = 0; t < N_THREADS; t++)
+        threads.spawn([&mdlist, &keys, t] () {
+            int wrong = 0;
+            for (int i = 1; i <= RANGE; i++)
+            {
+                // Each thread lists the keys in a different order.
+                vector< UpdateOp<int> > ops;
+                for (size_t k = 0; k < keys.size(); k++)
+                    ops.push_back({keys[(k * (2*t + 1)) % keys.size()],
+                                   i*N_THREADS + t, i % 5 == 0});
+                vector<int> previous = mdlist.multiUpdate(ops);
+                for (size_t k = 1; k < previous.size(); k++)
+                    if (previous[k] != previous[0])
+                        wrong++;
+            }
+            return wrong;
+        });
+    BOOST_CHECK_EQUAL(0, threads.join());
+    for (size_t k = 1; k < keys.size(); k++)
+        BOOST_CHECK_EQUAL(mdlist.find(keys[0]), mdlist.find(keys[k]));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
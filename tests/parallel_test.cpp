@@ -0,0 +1,74 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE MDListTest
+#include <boost/test/unit_test.hpp>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include "../mdlist.h"
+using namespace std;
+
+#define RANGE 1000
+#define N_THREADS 4
+
+BOOST_AUTO_TEST_SUITE(MDListParallelTest)
+
+BOOST_AUTO_TEST_CASE(ForEachTest) {
+    MDList<int> mdlist(8, 1LL << 32);
+    for (int i = 1; i <= N_THREADS*RANGE; i++)
+        mdlist.insert(i, i);
+    // Visits and values by key, the last slot
+    // takes keys out of range.
+    vector< atomic<int> > seen(N_THREADS*RANGE + 2);
+    vector< atomic<int> > values(N_THREADS*RANGE + 2);
+    for (size_t i = 0; i < seen.size(); i++)
+        seen[i] = values[i] = 0;
+    mdlist.parallel_for_each([&] (ULL key, int val) {
+        size_t i = min<ULL>(key, seen.size() - 1);
+        seen[i]++;
+        values[i] = val;
+    }, N_THREADS);
+    BOOST_CHECK_EQUAL(0, seen[0]);
+    BOOST_CHECK_EQUAL(0, seen.back());
+    for (int i = 1; i <= N_THREADS*RANGE; i++)
+    {
+        BOOST_CHECK_EQUAL(1, seen[i]);
+        BOOST_CHECK_EQUAL(i, values[i]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ReduceTest) {
+    MDList<int> mdlist(3, 64);
+    for (int i = 1; i < 64; i++)
+        mdlist.insert(i, i);
+    long sum = mdlist.parallel_reduce(0L,
+        [] (ULL, int val) { return (long) val; },
+        [] (long a, long b) { return a + b; }, N_THREADS);
+    BOOST_CHECK_EQUAL(63 * 64 / 2, sum);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentWriterTest) {
+    MDList<int> mdlist(8, 1LL << 32);
+    for (int i = 1; i <= N_THREADS*RANGE; i++)
+        mdlist.insert(i, i);
+    // Remove odd keys while scanning. Removals move even keys
+    // below them, so these may be missed or visited twice, but
+    // only pairs of the MDList are visited.
+    thread writer([&] () {
+        for (int i = 1; i <= N_THREADS*RANGE; i += 2)
+            mdlist.remove(i);
+    });
+    long wrong = mdlist.parallel_reduce(0L,
+        [] (ULL key, int val) {
+            return key < 1 || key > N_THREADS*RANGE || key != (ULL) val ? 1L : 0L;
+        },
+        [] (long a, long b) { return a + b; }, N_THREADS);
+    writer.join();
+    BOOST_CHECK_EQUAL(0, wrong);
+    // Without writers, every even key is visited once.
+    long evens = mdlist.parallel_reduce(0L,
+        [] (ULL key, int) { return key % 2 == 0 ? 1L : 100000L; },
+        [] (long a, long b) { return a + b; }, N_THREADS);
+    BOOST_CHECK_EQUAL(N_THREADS*RANGE / 2, evens);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,103 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE MDListTest
+#include <boost/test/unit_test.hpp>
+#include <vector>
+#include <algorithm>
+#include "../mdlist.h"
+using namespace std;
+
+#define D (3)
+#define M (8)
+
+BOOST_AUTO_TEST_SUITE(MDListPointTest)
+
+BOOST_AUTO_TEST_CASE(PointTest) {
+    MDList<int> mdlist(D, M*M*M);
+    vector<int> point = {1, 2, 3};
+    mdlist.insertPoint(point, 7);
+    BOOST_CHECK_EQUAL(7, mdlist.findPoint(point));
+    BOOST_CHECK_EQUAL(7, mdlist.find(1*M*M + 2*M + 3));
+    BOOST_CHECK_EQUAL(7, mdlist.removePoint(point));
+    BOOST_CHECK_EQUAL(NULL, mdlist.findPoint(point));
+    BOOST_CHECK_THROW(mdlist.findPoint({1, 2}), const char*);
+    BOOST_CHECK_THROW(mdlist.findPoint({1, 2, M}), const char*);
+}
+
+BOOST_AUTO_TEST_CASE(RangeQueryTest) {
+    MDList<int> mdlist(D, M*M*M);
+    for (int i = 1; i < M*M*M; i++)
+        mdlist.insert(i, i);
+    vector<int> lo = {2, 0, 5}, hi = {4, 3, 7};
+    vector< pair<vector<int>, int> > result = mdlist.rangeQuery(lo, hi);
+    BOOST_CHECK_EQUAL(3*4*3, result.size());
+    for (size_t i = 0; i < result.size(); i++)
+    {
+        vector<int>& p = result[i].first;
+        for (int d = 0; d < D; d++)
+        {
+            BOOST_CHECK(p[d] >= lo[d]);
+            BOOST_CHECK(p[d] <= hi[d]);
+        }
+        BOOST_CHECK_EQUAL(p[0]*M*M + p[1]*M + p[2], result[i].second);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(NearestTest) {
+    MDList<int> mdlist(D, M*M*M);
+    vector< vector<int> > points;
+    for (int i = 1; i < M*M*M; i += 7)
+    {
+        vector<int> p = {i / (M*M), i / M % M, i % M};
+        mdlist.insertPoint(p, i);
+        points.push_back(p);
+    }
+    vector<int> q = {3, 4, 5};
+    vector< pair<vector<int>, int> > result = mdlist.nearest(q, 5);
+    BOOST_REQUIRE_EQUAL(5, result.size());
+    // Compare distances with brute force.
+    vector<int> dist;
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        int s = 0;
+        for (int d = 0; d < D; d++)
+            s += (points[i][d] - q[d]) * (points[i][d] - q[d]);
+        dist.push_back(s);
+    }
+    sort(dist.begin(), dist.end());
+    for (int i = 0; i < 5; i++)
+    {
+        int s = 0;
+        for (int d = 0; d < D; d++)
+            s += (result[i].first[d] - q[d]) * (result[i].first[d] - q[d]);
+        BOOST_CHECK_EQUAL(dist[i], s);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(GrowTest) {
+    MDList<int> mdlist(D, M*M*M);
+    vector<int> point = {1, 2, 3};
+    mdlist.insertPoint(point, 7);
+    mdlist.insertPoint({7, 7, 7}, 8);
+    // A flat key beyond the key space adds leading dimensions.
+    mdlist.insert(1ULL << 40, 9);
+    BOOST_CHECK(mdlist.getD() > D);
+    BOOST_CHECK_EQUAL(7, mdlist.findPoint(point));
+    BOOST_CHECK_EQUAL(7, mdlist.find(1*M*M + 2*M + 3));
+    mdlist.insertPoint({0, 0, 1}, 10);
+    vector< pair<vector<int>, int> > inside = mdlist.rangeQuery({0, 0, 0}, {M-1, M-1, M-1});
+    BOOST_REQUIRE_EQUAL(3, inside.size());
+    sort(inside.begin(), inside.end());
+    BOOST_CHECK(inside[0].first == vector<int>({0, 0, 1}));
+    BOOST_CHECK(inside[1].first == point);
+    BOOST_CHECK(inside[2].first == vector<int>({7, 7, 7}));
+    // The flat key is not a point, however many are asked for.
+    vector< pair<vector<int>, int> > near = mdlist.nearest({1, 2, 4}, 10);
+    BOOST_REQUIRE_EQUAL(3, near.size());
+    BOOST_CHECK(near[0].first == point);
+    BOOST_CHECK_EQUAL(8, near[2].second);
+    BOOST_CHECK_EQUAL(7, mdlist.removePoint(point));
+    BOOST_CHECK_EQUAL(NULL, mdlist.findPoint(point));
+    BOOST_CHECK_EQUAL(9, mdlist.find(1ULL << 40));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,180 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE MDListTest
+#include <boost/test/unit_test.hpp>
+#include <vector>
+#include <random>
+#include <atomic>
+#include "../mdlist_rcu.h"
+#include "test_threads.h"
+using namespace std;
+
+#define D 8
+#define N 1000
+#define RANGE 1000
+#define N_THREADS 4
+
+BOOST_AUTO_TEST_SUITE(RCUMDListTest)
+
+BOOST_AUTO_TEST_CASE(InsertFindRemoveTest) {
+    RCUMDList<int> mdlist(D, N);
+    mt19937_64 rng(1);
+    vector<int> keys;
+    for (int i = 0; i < RANGE; i++)
+        keys.push_back(i);
+    shuffle(keys.begin(), keys.end(), rng);
+    for (int i = 0; i < RANGE; i++)
+        mdlist.insert(keys[i], keys[i] + 1);
+    for (int i = 0; i < RANGE; i++)
+        BOOST_CHECK_EQUAL(i + 1, mdlist.find(i));
+    mdlist.insert(7, 100);
+    BOOST_CHECK_EQUAL(100, mdlist.find(7));
+    shuffle(keys.begin(), keys.end(), rng);
+    for (int i = 0; i < RANGE / 2; i++)
+        BOOST_CHECK_EQUAL(keys[i] == 7 ? 100 : keys[i] + 1, mdlist.remove(keys[i]));
+    for (int i = 0; i < RANGE; i++)
+        BOOST_CHECK_EQUAL(i < RANGE / 2 ? 0 : keys[i] == 7 ? 100 : keys[i] + 1,
+                          mdlist.find(keys[i]));
+    BOOST_CHECK_EQUAL(NULL, mdlist.remove(keys[0]));
+}
+
+BOOST_AUTO_TEST_CASE(MultiUpdateTest) {
+    RCUMDList<int> mdlist(D, N);
+    mdlist.insert(1, 10);
+    vector< UpdateOp<int> > ops;
+    ops.push_back({1, NULL, true});
+    ops.push_back({2, 10, false});
+    // Grows the key space in the same version.
+    ops.push_back({1ULL << 40, 20, false});
+    vector<int> previous = mdlist.multiUpdate(ops);
+    BOOST_CHECK_EQUAL(10, previous[0]);
+    BOOST_CHECK_EQUAL(NULL, previous[1]);
+    BOOST_CHECK_EQUAL(NULL, previous[2]);
+    BOOST_CHECK_EQUAL(NULL, mdlist.find(1));
+    BOOST_CHECK_EQUAL(10, mdlist.find(2));
+    BOOST_CHECK_EQUAL(20, mdlist.find(1ULL << 40));
+    BOOST_CHECK(mdlist.getD() > D);
+    ops.push_back({2, 30, false});
+    BOOST_CHECK_THROW(mdlist.multiUpdate(ops), const char*);
+    BOOST_CHECK_EQUAL(10, mdlist.find(2));
+}
+
+BOOST_AUTO_TEST_CASE(EraseTest) {
+    RCUMDList<int, SignedCodec<long long> > mdlist(D, N);
+    for (int i = -RANGE; i <= RANGE; i++)
+        mdlist.insert(i, i + 2*RANGE);
+    mdlist.eraseRange(-10, 10);
+    for (int i = -RANGE; i <= RANGE; i++)
+        BOOST_CHECK_EQUAL(i >= -10 && i <= 10 ? 0 : i + 2*RANGE, mdlist.find(i));
+    mdlist.clear();
+    for (int i = -RANGE; i <= RANGE; i++)
+        BOOST_CHECK_EQUAL(NULL, mdlist.find(i));
+    mdlist.insert(5, 1);
+    BOOST_CHECK_EQUAL(1, mdlist.find(5));
+}
+
+#ifdef __SIZEOF_INT128__
+BOOST_AUTO_TEST_CASE(Int128Test) {
+    typedef unsigned __int128 U128;
+    RCUMDList<int, UInt128Codec> mdlist(D, N);
+    for (int i = 0; i < RANGE; i++)
+        mdlist.insert(((U128) i << 64) + i, i + 1);
+    BOOST_CHECK(mdlist.getD() > D);
+    for (int i = 0; i < RANGE; i++)
+    {
+        BOOST_CHECK_EQUAL(i + 1, mdlist.find(((U128) i << 64) + i));
+        BOOST_CHECK_EQUAL(NULL, mdlist.find(((U128) (i + RANGE) << 64) + i));
+    }
+    mdlist.eraseRange((U128) 1 << 64, (U128) RANGE << 64);
+    BOOST_CHECK_EQUAL(1, mdlist.find(0));
+    BOOST_CHECK_EQUAL(NULL, mdlist.find(((U128) 1 << 64) + 1));
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(ConcurrentTest) {
+    // Readers run while writers replace versions. Even keys
+    // are never removed, odd keys come and go in batches.
+    RCUMDList<int> mdlist(D, N);
+    for (int i = 0; i < RANGE; i += 2)
+        mdlist.insert(i, i + 1);
+    std::atomic<bool> done(false);
+    TestThreads readers;
+    for (int t = 0; t < N_THREADS; t++)
+        readers.spawn([&mdlist, &done, t] () {
+            int wrong = 0;
+            mt19937_64 rng(t);
+            while (!done.load())
+            {
+                int key = rng() % RANGE;
+                int val = mdlist.find(key);
+                if (key % 2 == 0 ? val != key + 1 : val != 0 && val != key + 1)
+                    wrong++;
+            }
+            return wrong;
+        });
+    TestThreads writers;
+    for (int t = 0; t < 2; t++)
+        writers.spawn([&mdlist, t] () {
+            for (int round = 0; round < 50; round++)
+            {
+                vector< UpdateOp<int> > ops;
+                for (int i = 1 + 2*t; i < RANGE; i += 4)
+                    ops.push_back({(ULL) i, i + 1, round % 2 == 1});
+                mdlist.multiUpdate(ops);
+            }
+            return 0;
+        });
+    writers.join();
+    done = true;
+    BOOST_CHECK_EQUAL(0, readers.join());
+    for (int i = 0; i < RANGE; i++)
+        BOOST_CHECK_EQUAL(i % 2 == 0 ? i + 1 : 0, mdlist.find(i));
+}
+
+BOOST_AUTO_TEST_CASE(BatchTest) {
+    // Each writer owns a group of keys, and each round writes
+    // the round number to every key of its group in one batch.
+    // Finds are not a snapshot, but rounds only increase, so a
+    // reader going through a group in the order of the batch
+    // never sees a key behind one it read before, unless a
+    // batch was seen in part.
+    RCUMDList<int> mdlist(D, N);
+    std::atomic<bool> done(false);
+    TestThreads readers;
+    for (int t = 0; t < N_THREADS; t++)
+        readers.spawn([&mdlist, &done, t] () {
+            int wrong = 0;
+            mt19937_64 rng(t);
+            while (!done.load())
+            {
+                int group = rng() % 2;
+                int last = 0;
+                for (int i = group; i < RANGE; i += 2)
+                {
+                    int val = mdlist.find(i);
+                    if (val < last)
+                        wrong++;
+                    last = val;
+                }
+            }
+            return wrong;
+        });
+    TestThreads writers;
+    for (int t = 0; t < 2; t++)
+        writers.spawn([&mdlist, t] () {
+            for (int round = 1; round <= 100; round++)
+            {
+                vector< UpdateOp<int> > ops;
+                for (int i = t; i < RANGE; i += 2)
+                    ops.push_back({(ULL) i, round, false});
+                mdlist.multiUpdate(ops);
+            }
+            return 0;
+        });
+    writers.join();
+    done = true;
+    BOOST_CHECK_EQUAL(0, readers.join());
+    for (int i = 0; i < RANGE; i++)
+        BOOST_CHECK_EQUAL(100, mdlist.find(i));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
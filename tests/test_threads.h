@@ -0,0 +1,82 @@
+/**
+ * @file test_threads.h
+ * @brief Worker threads for concurrent tests.
+ *
+ * Boost.Test assertions are not thread safe, so a worker
+ * returns the number of checks it failed instead, and the
+ * test checks the total once the workers are joined.
+ */
+
+#ifndef _test_threads_h_
+#define _test_threads_h_
+
+#include <vector>
+#include <thread>
+#include <atomic>
+
+/**
+ * TestThreads class.
+ * A group of worker threads, each returning its number
+ * of failed checks.
+ */
+class TestThreads
+{
+    /**
+     * The workers.
+     */
+    std::vector<std::thread>    threads;
+    /**
+     * Failed checks of finished workers.
+     */
+    std::atomic<int>            failures;
+
+    public:
+                                TestThreads();
+                                ~TestThreads();
+    template <class F>
+    void                        spawn(F);
+    int                         join();
+};
+
+/**
+ * TestThreads constructor.
+ */
+inline TestThreads::TestThreads ()
+{
+    this->failures = 0;
+}
+
+/**
+ * TestThreads destructor.
+ * Joins workers which are still running.
+ */
+inline TestThreads::~TestThreads ()
+{
+    this->join();
+}
+
+/**
+ * Starts a worker.
+ * @param worker Function returning its number of failed checks.
+ */
+template <class F>
+void TestThreads::spawn (F worker)
+{
+    this->threads.push_back(std::thread([this, worker] () {
+        this->failures += worker();
+    }));
+}
+
+/**
+ * Waits until every worker is done.
+ * @returns Total number of failed checks.
+ */
+inline int TestThreads::join ()
+{
+    for (size_t i = 0; i < this->threads.size(); i++)
+        this->threads[i].join();
+    this->threads.clear();
+    return this->failures.load();
+}
+
+#endif
@@ -0,0 +1,241 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <random>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include "../mdlist_trace.h"
+using namespace std;
+
+#define ULL unsigned long long
+
+typedef chrono::steady_clock Clock;
+
+/**
+ * Baseline: std::map behind a global lock.
+ */
+struct LockedMap
+{
+    map<ULL, ULL>   m;
+    mutex           map_mutex;
+
+    void            insert(ULL key, ULL val)
+                    {
+                        lock_guard<mutex> lock(map_mutex);
+                        m[key] = val;
+                    }
+    ULL             find(ULL key)
+                    {
+                        lock_guard<mutex> lock(map_mutex);
+                        map<ULL, ULL>::iterator it = m.find(key);
+                        return it == m.end() ? 0 : it->second;
+                    }
+    ULL             remove(ULL key)
+                    {
+                        lock_guard<mutex> lock(map_mutex);
+                        map<ULL, ULL>::iterator it = m.find(key);
+                        if (it == m.end())
+                            return 0;
+                        ULL val = it->second;
+                        m.erase(it);
+                        return val;
+                    }
+};
+
+/**
+ * Replays records on list. Records of one traced thread are
+ * replayed in order by one worker. In timed mode each operation
+ * waits for its time in the trace, and its latency counts from
+ * that time, so falling behind the trace shows up as latency.
+ * @param latencies Filled with latencies in nanoseconds per TraceOp.
+ * @returns Wall time in seconds.
+ */
+template <class List>
+double replay (List& list, const vector<TraceRecord>& records, int n_threads,
+               bool timed, vector<ULL> latencies[3])
+{
+    vector< vector<const TraceRecord*> > work(n_threads);
+    for (size_t i = 0; i < records.size(); i++)
+        work[records[i].thread % n_threads].push_back(&records[i]);
+    vector< vector<ULL> > local(n_threads * 3);
+    ULL first = records.empty() ? 0 : records[0].time;
+    Clock::time_point start = Clock::now() + chrono::milliseconds(10);
+    vector<thread> threads;
+    for (int t = 0; t < n_threads; t++)
+        threads.push_back(thread([&, t] () {
+            // All workers start together.
+            while (Clock::now() < start)
+                this_thread::yield();
+            for (size_t i = 0; i < work[t].size(); i++)
+            {
+                const TraceRecord* r = work[t][i];
+                Clock::time_point begin = Clock::now();
+                if (timed)
+                {
+                    Clock::time_point at = start + chrono::nanoseconds(r->time - first);
+                    if (at - begin > chrono::microseconds(100))
+                        this_thread::sleep_until(at - chrono::microseconds(50));
+                    while (Clock::now() < at)
+                        this_thread::yield();
+                    begin = at;
+                }
+                if (r->op == TRACE_INSERT)
+                    list.insert(r->key, r->key + 1);
+                else if (r->op == TRACE_FIND)
+                    list.find(r->key);
+                else
+                    list.remove(r->key);
+                local[t*3 + r->op % 3].push_back(
+                    chrono::duration_cast<chrono::nanoseconds>(Clock::now() - begin).count());
+            }
+        }));
+    for (int t = 0; t < n_threads; t++)
+        threads[t].join();
+    Clock::time_point end = Clock::now();
+    for (int t = 0; t < n_threads; t++)
+        for (int op = 0; op < 3; op++)
+            latencies[op].insert(latencies[op].end(),
+                                 local[t*3 + op].begin(), local[t*3 + op].end());
+    return chrono::duration<double>(end - start).count();
+}
+
+/**
+ * Prints latency percentiles of one operation type.
+ */
+void report (const char* name, vector<ULL>& latencies)
+{
+    if (latencies.empty())
+        return;
+    sort(latencies.begin(), latencies.end());
+    const double P[] = {50, 90, 99, 99.9};
+    cout << left << setw(8) << name << right << setw(10) << latencies.size();
+    for (int i = 0; i < 4; i++)
+        cout << setw(10) << latencies[(size_t) (P[i] / 100 * (latencies.size() - 1))];
+    cout << setw(10) << latencies.back() << "\n";
+}
+
+/**
+ * Records a random mix of 25% insert, 50% find, 25% remove.
+ */
+void generate (const char* path, int n_ops, int n_threads)
+{
+    TracedMDList<ULL> list(8, 1LL << 32, path);
+    vector<thread> threads;
+    for (int t = 0; t < n_threads; t++)
+        threads.push_back(thread([&, t] () {
+            mt19937_64 rng(t);
+            for (int i = t; i < n_ops; i += n_threads)
+            {
+                ULL key = rng() % (n_ops / 2 + 1);
+                int op = rng() % 4;
+                if (op == 0)
+                    list.insert(key, key + 1);
+                else if (op == 3)
+                    list.remove(key);
+                else
+                    list.find(key);
+            }
+        }));
+    for (int t = 0; t < n_threads; t++)
+        threads[t].join();
+}
+
+void usage ()
+{
+    cout << "Usage: trace_replay_test <trace> [-threads n] [-timed] [-map] [-D d] [-N n]\n"
+         << "       trace_replay_test -generate <trace> <ops> [-threads n]\n"
+         << "Replays a trace recorded with TracedMDList (mdlist_trace.h) on\n"
+         << "MDList, or on a locked std::map with -map. Operations run as\n"
+         << "fast as possible, or at their recorded times with -timed.\n";
+}
+
+int main (int argc, char** argv)
+{
+    const char* path = NULL;
+    int n_threads = thread::hardware_concurrency();
+    bool timed = false, use_map = false;
+    int D = 8;
+    ULL N = 1LL << 32;
+    int n_ops = -1;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-threads") && i + 1 < argc)
+            n_threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-timed"))
+            timed = true;
+        else if (!strcmp(argv[i], "-map"))
+            use_map = true;
+        else if (!strcmp(argv[i], "-D") && i + 1 < argc)
+            D = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-N") && i + 1 < argc)
+            N = strtoull(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "-generate") && i + 2 < argc)
+        {
+            path = argv[++i];
+            n_ops = atoi(argv[++i]);
+        }
+        else if (argv[i][0] != '-' && path == NULL)
+            path = argv[i];
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+    if (path == NULL || n_threads < 1)
+    {
+        usage();
+        return 1;
+    }
+    try
+    {
+        if (n_ops >= 0)
+        {
+            generate(path, n_ops, n_threads);
+            cout << "Recorded " << n_ops << " operations to " << path << "\n";
+            return 0;
+        }
+        vector<TraceRecord> records = readTrace(path);
+        stable_sort(records.begin(), records.end(),
+                    [] (const TraceRecord& a, const TraceRecord& b)
+        {
+            return a.time < b.time;
+        });
+        vector<ULL> latencies[3];
+        double seconds;
+        if (use_map)
+        {
+            LockedMap list;
+            seconds = replay(list, records, n_threads, timed, latencies);
+        }
+        else
+        {
+            MDList<ULL> list(D, N);
+            seconds = replay(list, records, n_threads, timed, latencies);
+        }
+        cout << "Replayed " << records.size() << " operations on "
+             << (use_map ? "std::map" : "MDList") << " with " << n_threads
+             << " threads " << (timed ? "at recorded times" : "as fast as possible") << "\n";
+        cout << fixed << setprecision(3) << "Time " << seconds << " s, "
+             << setprecision(0) << records.size() / seconds << " ops/s\n";
+        cout << "Latency in ns:\n" << left << setw(8) << "op" << right
+             << setw(10) << "count" << setw(10) << "p50" << setw(10) << "p90"
+             << setw(10) << "p99" << setw(10) << "p99.9" << setw(10) << "max" << "\n";
+        vector<ULL> all;
+        for (int op = 0; op < 3; op++)
+            all.insert(all.end(), latencies[op].begin(), latencies[op].end());
+        report("insert", latencies[TRACE_INSERT]);
+        report("find", latencies[TRACE_FIND]);
+        report("remove", latencies[TRACE_REMOVE]);
+        report("all", all);
+    }
+    catch (const char* e)
+    {
+        cout << e << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,67 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE MDListTest
+#include <boost/test/unit_test.hpp>
+#include <vector>
+#include <cstdio>
+#include "../mdlist_trace.h"
+#include "test_threads.h"
+using namespace std;
+
+#define D 8
+#define N 1000
+#define RANGE 10000
+#define N_THREADS 4
+#define TRACE_FILE "trace_test.bin"
+
+BOOST_AUTO_TEST_SUITE(MDListTraceTest)
+
+BOOST_AUTO_TEST_CASE(RecordTest) {
+    {
+        TracedMDList<int> mdlist(D, N, TRACE_FILE);
+        TestThreads threads;
+        for (int t = 0; t < N_THREADS; t++)
+            threads.spawn([&mdlist, t] () {
+                int wrong = 0;
+                for (int i = t*RANGE; i < (t+1)*RANGE; i++)
+                {
+                    mdlist.insert(i, i + 1);
+                    if (mdlist.find(i) != i + 1)
+                        wrong++;
+                    if (mdlist.remove(i) != i + 1)
+                        wrong++;
+                }
+                return wrong;
+            });
+        BOOST_CHECK_EQUAL(0, threads.join());
+        // Not recorded.
+        mdlist.getList().insert(1, 1);
+    }
+    vector<TraceRecord> records = readTrace(TRACE_FILE);
+    BOOST_CHECK_EQUAL(3*N_THREADS*RANGE, records.size());
+    // Each thread's records are in order of its operations.
+    vector<ULL> last_time(RANGE, 0);
+    vector<int> next(RANGE, -1);
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        TraceRecord& r = records[i];
+        BOOST_REQUIRE(r.thread < RANGE);
+        if (next[r.thread] == -1)
+            next[r.thread] = r.key / RANGE * RANGE * 3;
+        BOOST_REQUIRE_EQUAL(next[r.thread], r.key * 3 + r.op);
+        BOOST_REQUIRE(last_time[r.thread] <= r.time);
+        last_time[r.thread] = r.time;
+        next[r.thread]++;
+    }
+    remove(TRACE_FILE);
+}
+
+BOOST_AUTO_TEST_CASE(InvalidTraceTest) {
+    BOOST_CHECK_THROW(readTrace("no_such_trace.bin"), const char*);
+    FILE* file = fopen(TRACE_FILE, "wb");
+    fputs("not a trace", file);
+    fclose(file);
+    BOOST_CHECK_THROW(readTrace(TRACE_FILE), const char*);
+    remove(TRACE_FILE);
+}
+
+BOOST_AUTO_TEST_SUITE_END()